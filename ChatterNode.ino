@@ -10,11 +10,15 @@
 #include "src/events/UserEvents.h"
 #include "AlmostRandom.h"
 #include "src/globals/TBeamBoard.h"
+#include "src/tasks/TimerWheel.h"
+#include "src/tasks/StepRuntime.h"
 
 GpsEsp32RtClock* rtc;
 //SPIClass SDCardSPI(HSPI);
 
 CallbackRegistry* callbackRegistry;
+TimerWheel* timerWheel;
+StepRuntime* stepRuntime;
 ControlMode* control = nullptr;
 ControlLayer* controlLayer;
 UserEvents* userEvents;
@@ -33,7 +37,9 @@ enum ChatterStatus {
 ChatterStatus currentChatterStatus = ChatterUninitialized;
 bool initializing = true;
 bool attemptedExternalRtc = false;
-unsigned long homeShowTime = 0;
+
+unsigned long startChatterNextStep ();
+StepFunctionTask startupTask(startChatterNextStep); // stepped from the control layer until chatter is ready
 
 void setup() {
     // disable watchdogs (for now) since sd and radio usage have unpredictable delays
@@ -69,7 +75,11 @@ void setup() {
 
     userEvents = new UserEvents();
     callbackRegistry = new CallbackRegistry();
-    controlLayer = new ControlLayer(callbackRegistry);
+    timerWheel = new TimerWheel();
+    stepRuntime = new StepRuntime();
+    controlLayer = new ControlLayer(callbackRegistry, timerWheel, stepRuntime);
+
+    stepRuntime->start(&startupTask);
 }
 // startup
 // 1. power up all hardware
@@ -86,18 +96,24 @@ void setup() {
 
 void loop() 
 {
-    if (initializing) {
-        startChatterNextStep();
-        delay(10);
-    }
-    else if (controlLayer->needsOnboarded()) {
+    // startup steps are run by the control layer while initializing
+    if (!initializing && controlLayer->needsOnboarded()) {
         // go into onboard mode
         Logger::info("Want to onboard..", LogAppControl);
         controlLayer->joinCluster();
     }
 
     if (controlLayer != nullptr) {
+        uint8_t pmuEvents = loopPMU();
+        if (pmuEvents & PMU_EVENT_SHORT_PRESS) {
+            controlLayer->wakeDisplay(DisplayWakeButton);
+        }
+        if (pmuEvents & PMU_EVENT_POWER) {
+            controlLayer->wakeDisplay(DisplayWakePower);
+        }
+
         controlLayer->process(userEvents->dequeueNextEvent());
+        controlLayer->idle();
     }
     else {
         Logger::error("ctrl pointer is null", LogAppControl);
@@ -105,12 +121,12 @@ void loop()
 }
 
 // attempt to start chatter layer, when everything is read
-void startChatterNextStep () {
+// returns millis until the next step should run
+unsigned long startChatterNextStep () {
   if (PMU->isBatteryConnect()) {
     if(PMU->getBatteryPercent() < 10) {
       controlLayer->updateChatViewStatus("Low Battery");
-      delay(1000); // do nothing for a second
-      return;
+      return 1000; // do nothing for a second
     }
   }  
   // second, GPS/rtc must be setup
@@ -127,7 +143,7 @@ void startChatterNextStep () {
       // over on the other cpu
       if (control == nullptr) {
 
-        control = new HeadlessControlMode(DeviceTypeBase, rtc, callbackRegistry, SDCARD_CS, SDCardSPI, PMU);
+        control = new HeadlessControlMode(DeviceTypeBase, rtc, callbackRegistry, timerWheel, stepRuntime, SDCARD_CS, SDCardSPI, PMU);
       }
 
 
@@ -139,7 +155,7 @@ void startChatterNextStep () {
       else {
         controlLayer->updateChatViewStatus("Insert Valid SD Card");
         Logger::error("Insert valid SD card...", LogAppControl);
-        delay(3000);
+        return 3000;
       }
 
     }
@@ -213,10 +229,10 @@ void startChatterNextStep () {
     }
     else if (currentChatterStatus == ChatterAlmostReady) {
       // allow half a second for the password prompt to go away if it needs to
-      if (homeShowTime == 0) {
-        homeShowTime = millis() + 500;
+      if (timerWheel->isIdle(TimerHomeShow)) {
+        timerWheel->schedule(TimerHomeShow, 500);
       }
-      else if (homeShowTime < millis()) {
+      else if (timerWheel->consume(TimerHomeShow)) {
         currentChatterStatus = ChatterReady;
         controlLayer->setInitialized(true); 
       }
@@ -227,9 +243,11 @@ void startChatterNextStep () {
         // queue event showing transition to home
         userEvents->queueEvent(ViewChangeHome);
         control->hideChatProgress();
-
+        return STEP_FINISHED;
     }
   }
+
+  return 10;
 }
 
 bool isRtcReady () {
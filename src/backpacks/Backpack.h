@@ -1,6 +1,7 @@
 #include "../globals/Globals.h"
 #include "ChatterAll.h"
 #include "../events/CommunicatorEvent.h"
+#include "../tasks/StepRuntime.h"
 
 #ifndef BACKPACK_H
 #define BACKPACK_H
@@ -12,7 +13,7 @@ enum BackpackType {
 
 class Backpack {
     public:
-        Backpack (Chatter* _chatter, ChatStatusCallback* _control) { chatter = _chatter; control = _control; }
+        Backpack (Chatter* _chatter, ChatStatusCallback* _control, StepRuntime* _runtime) { chatter = _chatter; control = _control; runtime = _runtime; }
 
         virtual bool handleUserEvent (CommunicatorEventType eventType) = 0;
         virtual bool handleMessage (const uint8_t* message, int messageSize, const char* senderId, const char* recipientId) = 0;
@@ -24,6 +25,7 @@ class Backpack {
     protected:
         Chatter* chatter;
         ChatStatusCallback* control;
+        StepRuntime* runtime; // anything that waits runs as a step task, never in delay()
 };
 
 #endif
\ No newline at end of file
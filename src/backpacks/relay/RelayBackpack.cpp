@@ -52,16 +52,23 @@ bool RelayBackpack::handleMessage (const uint8_t* message, int messageSize, cons
 
 
 void RelayBackpack::triggerRelay() {
-    // set high for 5 seconds, then set low
-    digitalWrite(RELAY_OUT_PIN, HIGH);
-
-    Logger::warn("Relay On", LogAppControl);
+    // triggering again while on restarts the pulse, so it stays on another 5 sec
+    runtime->start(&relayPulse);
+}
 
-    unsigned long startTime = millis();
-    while (millis() - startTime < 5000) {
-        delay(100);
+void RelayBackpack::stepRelayPulse (StepTask* task, unsigned long now) {
+    // set high for 5 seconds, then set low
+    switch (task->getStage()) {
+        case 0:
+            digitalWrite(RELAY_OUT_PIN, HIGH);
+            Logger::warn("Relay On", LogAppControl);
+            task->setStage(1);
+            task->sleepFor(now, RELAY_PULSE_MILLIS);
+            break;
+        default:
+            digitalWrite(RELAY_OUT_PIN, LOW);
+            Logger::warn("Relay Off", LogAppControl);
+            task->finish();
+            break;
     }
-    digitalWrite(RELAY_OUT_PIN, LOW);
-
-    Logger::warn("Relay Off", LogAppControl);
 }
\ No newline at end of file
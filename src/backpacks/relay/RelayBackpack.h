@@ -8,10 +8,11 @@
 #define RELAYBACKPACK_H
 
 #define RELAY_OUT_PIN 46
+#define RELAY_PULSE_MILLIS 5000 // how long the relay stays on when triggered
 
 class RelayBackpack : public Backpack {
     public:
-        RelayBackpack (Chatter* _chatter, ChatStatusCallback* _control) : Backpack(_chatter, _control) {}
+        RelayBackpack (Chatter* _chatter, ChatStatusCallback* _control, StepRuntime* _runtime) : Backpack(_chatter, _control, _runtime), relayPulse(this, &RelayBackpack::stepRelayPulse) {}
 
         bool handleUserEvent (CommunicatorEventType eventType);
         bool handleMessage (const uint8_t* message, int messageSize, const char* senderId, const char* recipientId);
@@ -23,6 +24,8 @@ class RelayBackpack : public Backpack {
 
     protected:
         void triggerRelay ();
+        void stepRelayPulse (StepTask* task, unsigned long now);
+        StepMethodTask<RelayBackpack> relayPulse;
 
         bool running = false;
         bool remoteEnabled = true;
@@ -0,0 +1,45 @@
+#include "AckQueue.h"
+
+AckQueueResult AckQueue::queueAck (const char* recipient, const char* messageId, uint16_t traceId) {
+  // a retransmit of something we already owe an ack for only needs one ack
+  for (uint8_t i = 0; i < count; i++) {
+    if (memcmp(acks[i].recipient, recipient, CHATTER_DEVICE_ID_SIZE) == 0 && strncmp(acks[i].messageId, messageId, ACK_MESSAGE_ID_MAX) == 0) {
+      coalescedCount++;
+      return AckCoalesced;
+    }
+  }
+
+  if (count >= ACK_QUEUE_SIZE) {
+    return AckQueueFull;
+  }
+
+  snprintf(acks[count].recipient, CHATTER_DEVICE_ID_SIZE+1, "%s", recipient);
+  snprintf(acks[count].messageId, ACK_MESSAGE_ID_MAX+1, "%s", messageId);
+  acks[count].traceId = traceId;
+  acks[count].queuedAt = millis();
+  count++;
+  return AckQueued;
+}
+
+void AckQueue::pop () {
+  if (count > 0) {
+    // shift remaining acks to the left, keeps them in arrival order
+    for (uint8_t i = 1; i < count; i++) {
+      acks[i-1] = acks[i];
+    }
+    count--;
+  }
+}
+
+void AckQueue::ackSent (bool viaMesh) {
+  if (viaMesh) {
+    meshCount++;
+  }
+  else {
+    sentCount++;
+  }
+}
+
+void AckQueue::ackFailed () {
+  failedCount++;
+}
@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "../globals/Globals.h"
+#include "ChatterAll.h"
+
+#ifndef ACKQUEUE_H
+#define ACKQUEUE_H
+
+#define ACK_QUEUE_SIZE 8 // acks that can be held back during one receive burst
+#define ACK_MESSAGE_ID_MAX 8 // room for the chatter message id
+
+enum AckQueueResult {
+  AckQueued = 0,
+  AckCoalesced = 1, // already owed, nothing new was held
+  AckQueueFull = 2
+};
+
+struct PendingAck {
+  char recipient[CHATTER_DEVICE_ID_SIZE+1];
+  char messageId[ACK_MESSAGE_ID_MAX+1];
+  uint16_t traceId; // latency trace of the message being acked
+  unsigned long queuedAt;
+};
+
+/**
+ * Holds acknowledgements back while a receive burst is in progress, so
+ * consecutive retrieveMessage calls aren't separated by radio transmits.
+ * The same ack requested twice (sender retransmitted) is only sent once.
+ */
+class AckQueue {
+  public:
+    AckQueueResult queueAck (const char* recipient, const char* messageId, uint16_t traceId);
+
+    uint8_t getCount () { return count; }
+    bool isEmpty () { return count == 0; }
+    PendingAck* peek () { return count > 0 ? &acks[0] : nullptr; }
+    void pop ();
+
+    void ackSent (bool viaMesh);
+    void ackFailed ();
+    void receiveSlotRecovered () { slotsRecovered++; }
+
+    unsigned long getCoalescedCount () { return coalescedCount; }
+    unsigned long getSentCount () { return sentCount; }
+    unsigned long getMeshCount () { return meshCount; }
+    unsigned long getFailedCount () { return failedCount; }
+    unsigned long getSlotsRecovered () { return slotsRecovered; }
+
+  protected:
+    PendingAck acks[ACK_QUEUE_SIZE];
+    uint8_t count = 0;
+
+    unsigned long coalescedCount = 0;
+    unsigned long sentCount = 0;
+    unsigned long meshCount = 0;
+    unsigned long failedCount = 0;
+    unsigned long slotsRecovered = 0;
+};
+
+#endif
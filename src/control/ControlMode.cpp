@@ -1,12 +1,19 @@
 #include "ControlMode.h"
 
-ControlMode::ControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu) { 
+ControlMode::ControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, TimerWheel* _timers, StepRuntime* _runtime, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu) :
+  storageSession(_sdPin, &_sdSpiClass),
+  factoryResetHold(this, &ControlMode::stepFactoryResetHold),
+  joinRestart(this, &ControlMode::stepJoinRestart) { 
   deviceType = _deviceType; 
   rtc = _rtc; 
-  sdPin = _sdPin, 
   globalCallbackRegistry = _callbackRegistry;
-  sdSpiClass = &_sdSpiClass;
+  timers = _timers;
+  runtime = _runtime;
   pmu = _pmu;
+
+  // a radio interrupt ends any idle early
+  idleScheduler.setWakePin(LORA_INT);
+  idleScheduler.setLightSleepAllowed(IDLE_LIGHT_SLEEP_ENABLED);
 }
 
 StartupState ControlMode::initEncryptedStorage () {
@@ -107,7 +114,7 @@ StartupState ControlMode::startChatter() {
 
       // check if backpack needs initialized
       if (BACKPACK_RELAY_ENABLED) {
-        backpacks[numBackpacks] = new RelayBackpack (chatter, this);
+        backpacks[numBackpacks] = new RelayBackpack (chatter, this, runtime);
         if (backpacks[numBackpacks]->init()) {
           Logger::info("Relay backpack ready!", LogAppControl);
           numBackpacks += 1;
@@ -136,10 +143,19 @@ StartupState ControlMode::startChatter() {
       chatter->setGraphLoggingEnabled(true);
     }
 
-    // force pruning on startup. otherwise, repeated startups
-    // can get really slow
-    showStatus("Prune storage");
-    chatter->pruneStorage(true);
+    // startup used to force a full prune here, so repeated startups didn't pile up
+    // stale data. it's deferred now, and runs forced once the node is up. a prune the
+    // last boot didn't finish gets the same delay, in case that prune is what took it down
+    if (chatter->getDeviceStore()->getCustomPreference(StoredPrefPruneState) == STORAGE_PRUNE_RUNNING) {
+      Logger::warn("Last prune didn't finish", LogAppControl);
+    }
+    timers->schedule(TimerStoragePrune, STORAGE_PRUNE_STARTUP_DELAY);
+
+    // a fast reset before this boot may have left files to delete
+    trashPending = SD.exists(STORAGE_TRASH_ROOT);
+
+    // only steps if a reset button is wired (FACTORY_RESET_PIN)
+    watchFactoryResetButton();
 
     //chatter->getMeshPacketStore()->clearAllPackets();
 
@@ -147,33 +163,32 @@ StartupState ControlMode::startChatter() {
 
     // set up the storage zone storage data
     for (uint8_t zoneCount = 0; zoneCount < CHATTER_STORAGE_ZONE_COUNT; zoneCount++) {
-      nextFlush[zoneCount] = 0;
-
       switch (zoneCount) {
         case StorageZoneMessages:
-          flushDelay[zoneCount] = 20000;
+          flushScheduler.setDelay(zoneCount, 20000);
           break;
         case StorageZonePackets:
-          flushDelay[zoneCount] = 120000;
+          flushScheduler.setDelay(zoneCount, 120000);
           break;
         case StorageZoneMeshPackets:
-          flushDelay[zoneCount] = 60000;
+          flushScheduler.setDelay(zoneCount, 60000);
           break;
         case StorageZonePingTable:
-          flushDelay[zoneCount] = 90000;
+          flushScheduler.setDelay(zoneCount, 90000);
           break;
         case StorageZoneMeshGraph:
-          flushDelay[zoneCount] = 60000*5;
+          flushScheduler.setDelay(zoneCount, 60000*5);
           break;
         case StorageZoneLocations:
-          flushDelay[zoneCount] = 70000;
+          flushScheduler.setDelay(zoneCount, 70000);
           break;
         default:
-          flushDelay[zoneCount] = 30000;
+          flushScheduler.setDelay(zoneCount, 30000);
           break;
       }
 
     }
+    flushScheduler.setBudget(STORAGE_FLUSH_BUDGET_MILLIS);
 
     controlModeInitializing = false;
 
@@ -286,22 +301,22 @@ uint8_t ControlMode::promptBackupPassword (char* buffer) {
   return 0;
 }
 
-void ControlMode::queueOutMessage (uint8_t* newMessage, int newMessageLength, const char* recipient, unsigned long scheduledDelay) {
-  memcpy(outMessageBuffer, newMessage, newMessageLength);
-  outMessageBufferLength = newMessageLength;
-  sprintf(outMessageRecipient, "%s", recipient);
-  outMessageBufferType = MessageTypePlain;
-  outMessageStatus = ControlMessageNew;
-  outMessageScheduledTime = millis() + scheduledDelay;
+bool ControlMode::queueOutMessage (uint8_t* newMessage, int newMessageLength, const char* recipient, unsigned long scheduledDelay, OutboundPriority priority) {
+  if (outboundQueue.enqueue(newMessage, newMessageLength, recipient, false, MessageTypePlain, scheduledDelay, priority, activeTraceId)) {
+    // the trace isn't finished until this reply leaves
+    latencyTracer.expect(activeTraceId);
+    timers->scheduleEarliest(TimerOutbound, millis() + scheduledDelay);
+    return true;
+  }
+  return false;
 }
 
-void ControlMode::queueOutBroadcast (uint8_t* newMessage, int newMessageLength, unsigned long scheduledDelay) {
-  memcpy(outMessageBuffer, newMessage, newMessageLength);
-  outMessageBufferLength = newMessageLength;
-  sprintf(outMessageRecipient, "%s", chatter->getClusterBroadcastId());
-  outMessageBufferType = MessageTypePlain;
-  outMessageStatus = ControlMessageNew;
-  outMessageScheduledTime = millis() + scheduledDelay;
+bool ControlMode::queueOutBroadcast (uint8_t* newMessage, int newMessageLength, unsigned long scheduledDelay) {
+  if (outboundQueue.enqueue(newMessage, newMessageLength, chatter->getClusterBroadcastId(), true, MessageTypePlain, scheduledDelay, OutboundPriorityBulk)) {
+    timers->scheduleEarliest(TimerOutbound, millis() + scheduledDelay);
+    return true;
+  }
+  return false;
 }
 
 void ControlMode::queuePasswordChange (const char* newPassword) {
@@ -356,7 +371,9 @@ void ControlMode::notifyUiInterruptReceived () {
 void ControlMode::processOneCycle(ControlCycleType cycleType) {
   if (factoryResetQueued) {
     listeningForMessages = false;
-    wipeStorage();
+    if (!FACTORY_RESET_FAST || !moveStorageToTrash()) {
+      wipeStorage();
+    }
     closeStorage();
     restartDevice();
 
@@ -391,111 +408,95 @@ void ControlMode::processOneCycle(ControlCycleType cycleType) {
     closeStorage();
   }
 
+  if (onboardState != OnboardIdle) {
+    // the assistant has the radio while joining, storage and gps keep going
+    stepJoining();
+    maintainStorage(cycleType);
+    if (cycleType != ControlCycleRadio) {
+      loopStalls.enter(StallPhaseGps);
+      rtc->cycleOnce();
+      refreshGpsCoords();
+      loopStalls.exit(StallPhaseGps);
+    }
+    return;
+  }
+
   int numPacketsThisCycle = 0;
 
   // reset the progress
   updateChatProgress(0.0);
 
-  if (outMessageStatus == ControlMessageNew) {
-    // if we've reached the scheduled time, send it
-    if (millis() >= outMessageScheduledTime){
-      outMessageStatus = ControlMessageScheduled;
-    }
-  }
-  else if (outMessageStatus == ControlMessageScheduled) {
-    outMessageScheduledTime = 0; // clear the schedule timer, since its getting picked up now
-    outMessageStatus = ControlMessageSendingDirect;
-
-    // is it broadcast or DM
-    if (memcmp(outMessageRecipient, chatter->getClusterBroadcastId(), CHATTER_DEVICE_ID_SIZE) == 0) {
-      if(chatter->broadcast(outMessageBuffer, outMessageBufferLength)) {
-        outMessageStatus = ControlMessageSentDirect;
-        Logger::info("Broadcast sent", LogAppControl);
-      }
-      else {
-        outMessageStatus = ControlMessageFailed;
-        Logger::warn("Broadcast sent", LogAppControl);
-      }
-    }
-    else {
-      // try sending direct
-      ChatterMessageFlags flags;
-      flags.Flag0 = outMessageBufferType;
-      flags.Flag2 = AckRequestTrue;
-
-      if(chatter->send(outMessageBuffer, outMessageBufferLength, outMessageRecipient, &flags)) {
-        outMessageStatus = ControlMessageSentDirect;
-      }
-    }
-  }
-  else if (outMessageStatus == ControlMessageSendingDirect) {
-      // new failed, try sending mesh
-    ChatterMessageFlags flags;
-    flags.Flag0 = messageBufferType;
+  // advance anything waiting in the outbound queue
+  loopStalls.enter(StallPhaseSend);
+  processOutbound();
+  loopStalls.exit(StallPhaseSend);
 
-    // drop message into mesh
-    if (chatter->sendViaMesh(outMessageBuffer, outMessageBufferLength, outMessageRecipient, &flags)) {
-      outMessageStatus = ControlMessageMeshQueued;
-    }
-    else {
-      outMessageStatus = ControlMessageFailed;
-    }
-  }
-  else if (listeningForMessages) {
+  if (listeningForMessages) {
     bool userInt = false;
     showStatus("Listening");
-    while (chatter->hasMessage(cycleType == ControlCycleFull ? CHATTER_POLL_COUNT_PER_CYCLE_FULL : CHATTER_POLL_COUNT_PER_CYCLE_RESPONSIVE) && numPacketsThisCycle++ < maxReadPacketsPerCycle) {
+
+    uint8_t readBudget = receiveBudget.getReadBudget();
+    uint8_t pollCount = receiveBudget.getPollCount(cycleType == ControlCycleResponsive);
+    loopStalls.enter(StallPhaseReceive);
+    unsigned long receiveStart = micros();
+    while (chatter->hasMessage(pollCount) && numPacketsThisCycle++ < readBudget) {
+      uint16_t traceId = latencyTracer.begin(micros());
       showStatus("Receiving");
+      if (!ackQueue.isEmpty()) {
+        // previously an ack transmit would have sat in front of this read
+        ackQueue.receiveSlotRecovered();
+      }
       if(chatter->retrieveMessage() && chatter->getMessageType() == MessageTypeComplete) {
+        latencyTracer.retrieved(traceId);
         Logger::info("Processing trusted message...", LogAppControl);
 
-        messageBufferLength = chatter->getMessageSize();
-        memcpy(messageBuffer, chatter->getTextMessage(), messageBufferLength);
-        messageBuffer[messageBufferLength] = 0;
+        // sender is tiny and needs to be a string, the payload stays where chatter put it
         memcpy(otherDeviceId, chatter->getLastSender(), CHATTER_DEVICE_ID_SIZE);
         otherDeviceId[CHATTER_DEVICE_ID_SIZE] = 0;
 
-        // send ack (later, queue this)
-        if (!chatter->isAcknowledgement()) {
-          if (memcmp(chatter->getLastRecipient(), chatter->getDeviceId(), CHATTER_DEVICE_ID_SIZE) == 0) {
-            Logger::debug("sending ack..", LogAppControl);
-            if(!chatter->sendAck(otherDeviceId, chatter->getMessageId())) {
-              Logger::debug("Ack direct failed", LogAppControl);
-              if (chatter->isMeshEnabled()) {
-                chatter->sendAckViaMesh(otherDeviceId, chatter->getMessageId());
-              }
-            }
-          }
-        }
-
-        // if it's a command, execute it
-        if (chatter->getMessageFlags().Flag0 == MessageTypeControl && isRemoteCommand(messageBuffer, messageBufferLength)) {
-          // in node, remote commands are always enabled
-          //if (preferenceHandler->isPreferenceEnabled(PreferenceRemoteConfigEnabled)) {
-            Logger::warn("Executing command: ", (const char*)messageBuffer, LogAppControl);
-            executeRemoteCommand(messageBuffer, otherDeviceId);
-          //}
-          //else {
-          //  Logger::warn("Received remote command, but not enabled on this device!", LogAppControl);
-          //}
-        }
-        else {
-          ((ChatterViewCallback*)globalCallbackRegistry->getCallback(CallbackChatStatus))->messageReceived();
-        }
-
+        MessageView inbound;
+        inbound.data = chatter->getTextMessage();
+        inbound.length = chatter->getMessageSize();
+        inbound.sender = otherDeviceId;
+        inbound.messageId = chatter->getMessageId();
+        inbound.flags = chatter->getMessageFlags();
+        inbound.isAck = chatter->isAcknowledgement();
+        inbound.addressedToUs = memcmp(chatter->getLastRecipient(), chatter->getDeviceId(), CHATTER_DEVICE_ID_SIZE) == 0;
+
+        activeTraceId = traceId;
+        handleInboundMessage(inbound);
+        activeTraceId = LATENCY_TRACE_NONE;
+        latencyTracer.release(traceId);
+      }
+      else {
+        latencyTracer.discard(traceId);
       }
 
       ((ChatterViewCallback*)globalCallbackRegistry->getCallback(CallbackChatStatus))->yieldForProcessing();
       userInt = userInterrupted();
     }
 
-    // sync every loop, strategy decides how often
-    if (numPacketsThisCycle == 0 && userInt == false) {
+    // if the loop stopped on the budget, there was still something waiting
+    bool backlogged = numPacketsThisCycle > readBudget;
+    uint8_t packetsRead = backlogged ? readBudget : numPacketsThisCycle;
+    // held acks go out right below, only the outbound queue is still waiting after this cycle
+    receiveBudget.update(packetsRead, backlogged, micros() - receiveStart, outboundQueue.getCount());
+    loopStalls.exit(StallPhaseReceive);
+
+    // burst is drained, send any acks that were held back
+    loopStalls.enter(StallPhaseSend);
+    flushAcks();
+    loopStalls.exit(StallPhaseSend);
+
+    // sync every loop, strategy decides how often. it's bulk traffic, so it waits if replies are still ready to go
+    if (numPacketsThisCycle == 0 && userInt == false && !outboundQueue.hasReadyAbove(OutboundPriorityBulk)) {
       if (clearMeshPacketsIfQueued() == false) {
         showStatus("Mesh");
+        loopStalls.enter(StallPhaseMeshSync);
         if(chatter->syncMesh()) {
           Logger::info("Mesh activity occurred", LogAppControl);
         }
+        loopStalls.exit(StallPhaseMeshSync);
       }
     }
     showStatus("Ready");
@@ -504,30 +505,313 @@ void ControlMode::processOneCycle(ControlCycleType cycleType) {
       return;
     }
 
-    // gps if time
-    /*if (numPacketsThisCycle == 0) {
-      refreshGpsCoords();
-    }*/
-
-    // the timings of these are controlled within chatter layer
-    if (cycleType == ControlCycleFull) {
-      if (cycleType == ControlCycleFull && chatter->isTimeToPruneStorage()) {
-        if (openStorage()) {
-          chatter->pruneStorage();
-          closeStorage();
-        }
-        else {
-            Logger::warn("Storage unavailable for pruning", LogAppControl);
-        }
+    maintainStorage(cycleType);
+  }
+
+  // flush gps buffer, if this rtc needs it
+  if (cycleType != ControlCycleRadio) {
+    loopStalls.enter(StallPhaseGps);
+    rtc->cycleOnce();
+    refreshGpsCoords();
+    loopStalls.exit(StallPhaseGps);
+  }
+}
+
+void ControlMode::maintainStorage (ControlCycleType cycleType) {
+  // the timings of these are controlled within chatter layer
+  if (cycleType == ControlCycleFull) {
+    if (!pruneStorageIfDue(&loopStalls)) {
+      loopStalls.enter(StallPhaseFlush);
+      flushStorage();
+      loopStalls.exit(StallPhaseFlush);
+      emptyTrashStep(&loopStalls);
+    }
+  }
+  else if (cycleType == ControlCycleRadio) {
+    // the housekeeping task does the writing
+    journalStorageFlushes();
+  }
+}
+
+bool ControlMode::pruneStorageIfDue (StallMonitor* stalls) {
+  if (!prunePending) {
+    if (timers->consume(TimerStoragePrune)) {
+      pruneForced = true;
+    }
+    else if (!chatter->isTimeToPruneStorage()) {
+      return false;
+    }
+    prunePending = true;
+    pruneDueAt = millis();
+  }
+
+  // chatter only prunes everything at once, so the prune holds storage (and in split
+  // mode the chatter lock) until it's done. the most it can do is wait for a quiet cycle
+  if (hasPendingWork() && (unsigned long)(millis() - pruneDueAt) < STORAGE_PRUNE_MAX_DEFER) {
+    return false;
+  }
+
+  stalls->enter(StallPhasePrune);
+  bool pruned = false;
+  if (openStorage()) {
+    // if this doesn't get cleared, the next boot reports it
+    chatter->getDeviceStore()->setCustomPreference(StoredPrefPruneState, STORAGE_PRUNE_RUNNING);
+    unsigned long pruneStart = millis();
+    chatter->pruneStorage(pruneForced);
+    unsigned long pruneMillis = millis() - pruneStart;
+    chatter->getDeviceStore()->setCustomPreference(StoredPrefPruneState, STORAGE_PRUNE_COMPLETE);
+    closeStorage();
+
+    pruneCount++;
+    if (pruneMillis > worstPruneMillis) {
+      worstPruneMillis = pruneMillis;
+    }
+    sprintf(logBuffer, "Storage pruned in %lu ms%s, waited %lu ms for a quiet cycle", pruneMillis, pruneForced ? " (forced)" : "", pruneStart - pruneDueAt);
+    Logger::info(logBuffer, LogAppControl);
+
+    prunePending = false;
+    pruneForced = false;
+    pruned = true;
+  }
+  else {
+    Logger::warn("Storage unavailable for pruning", LogAppControl);
+  }
+  stalls->exit(StallPhasePrune);
+  return pruned;
+}
+
+bool ControlMode::processHousekeeping () {
+  // flushes arrive through the storage journal, see writeStorageJournal
+  bool storageWritten = pruneStorageIfDue(&housekeepingStalls);
+  if (!storageWritten) {
+    emptyTrashStep(&housekeepingStalls);
+  }
+
+  // flush gps buffer, if this rtc needs it
+  housekeepingStalls.enter(StallPhaseGps);
+  rtc->cycleOnce();
+  refreshGpsCoords();
+  housekeepingStalls.exit(StallPhaseGps);
+  return storageWritten;
+}
+
+// moves each queued outbound message one step through its lifecycle,
+// returns the number of radio sends that were attempted
+uint8_t ControlMode::processOutbound () {
+  uint8_t sendsThisCycle = 0;
+
+  // acks are the most time critical class, anything still held goes before the rest
+  flushAcks();
+
+  if (outboundQueue.isEmpty()) {
+    return 0;
+  }
+
+  // only look at schedules when the earliest one has come due
+  unsigned long now = millis();
+  bool scheduleDue = timers->consume(TimerOutbound);
+
+  for (uint8_t slot = 0; slot < OUTBOUND_QUEUE_SIZE; slot++) {
+    OutboundMessage* outMessage = outboundQueue.getEntry(slot);
+
+    // new, or backing off after a failed attempt
+    bool waiting = outMessage->status == ControlMessageNew || outMessage->status == ControlMessageSendingDirect || outMessage->status == ControlMessageSendingMesh;
+    if (waiting && scheduleDue) {
+      // if we've reached the scheduled time, it can go out
+      if (TimerWheel::deadlineReached(now, outMessage->scheduledTime)) {
+        outMessage->status = ControlMessageScheduled;
       }
       else {
-        flushStorage();
+        timers->scheduleEarliest(TimerOutbound, outMessage->scheduledTime);
       }
     }
+
   }
 
-  // flush gps buffer, if this rtc needs it
-  rtc->cycleOnce();
+  // the scheduler picks by class, whatever is left waits for the next cycle so receive isn't starved
+  OutboundMessage* outMessage;
+  while (sendsThisCycle < OUTBOUND_MAX_SENDS_PER_CYCLE && (outMessage = outboundQueue.selectNext()) != nullptr) {
+    sendsThisCycle++;
+    sendOutbound(outMessage);
+  }
+
+  outboundQueue.reclaim();
+  return sendsThisCycle;
+}
+
+bool ControlMode::sendOutbound (OutboundMessage* outMessage) {
+  if (outMessage->attempts == 0 && !outMessage->isBroadcast) {
+    // decide once how long the direct path is worth trying
+    const OutboundRetryPolicy& policy = outboundQueue.getRetryPolicy();
+    if (!chatter->isMeshEnabled()) {
+      outMessage->directAttempts = policy.maxAttempts;
+    }
+    else {
+      outMessage->directAttempts = isRecipientNearby(outMessage->recipient) ? policy.directAttemptsNear : policy.directAttemptsFar;
+    }
+  }
+
+  if (outMessage->attempts == 0) {
+    outboundQueue.recordAttempt(outMessage->priority, millis() - outMessage->scheduledTime);
+  }
+
+  bool direct = outMessage->isBroadcast || outMessage->attempts < outMessage->directAttempts;
+  if (direct ? sendOutboundDirect(outMessage) : sendOutboundMesh(outMessage)) {
+    latencyTracer.replySent(outMessage->traceId);
+    return true;
+  }
+
+  if (outboundQueue.attemptFailed(outMessage, millis())) {
+    // back off, then go again on whichever path the policy says is next
+    direct = outMessage->isBroadcast || outMessage->attempts < outMessage->directAttempts;
+    outMessage->status = direct ? ControlMessageSendingDirect : ControlMessageSendingMesh;
+    timers->scheduleEarliest(TimerOutbound, outMessage->scheduledTime);
+
+    sprintf(logBuffer, "Send attempt %d failed, retry %s in %lu ms", outMessage->attempts, direct ? "direct" : "mesh", outMessage->scheduledTime - millis());
+    Logger::info(logBuffer, LogAppControl);
+  }
+  else {
+    latencyTracer.replySent(outMessage->traceId);
+    Logger::warn(outMessage->isBroadcast ? "Broadcast failed" : "Send failed, out of attempts", LogAppControl);
+  }
+  return false;
+}
+
+bool ControlMode::sendOutboundDirect (OutboundMessage* outMessage) {
+  // is it broadcast or DM
+  if (outMessage->isBroadcast) {
+    if(chatter->broadcast(outMessage->buffer, outMessage->length)) {
+      outMessage->status = ControlMessageSentDirect;
+      Logger::info("Broadcast sent", LogAppControl);
+      return true;
+    }
+    return false;
+  }
+
+  // try sending direct
+  ChatterMessageFlags flags;
+  flags.Flag0 = outMessage->type;
+  flags.Flag2 = AckRequestTrue;
+
+  if(chatter->send(outMessage->buffer, outMessage->length, outMessage->recipient, &flags)) {
+    outMessage->status = ControlMessageSentDirect;
+    return true;
+  }
+  return false;
+}
+
+bool ControlMode::sendOutboundMesh (OutboundMessage* outMessage) {
+  ChatterMessageFlags flags;
+  flags.Flag0 = outMessage->type;
+
+  // drop message into mesh
+  if (chatter->sendViaMesh(outMessage->buffer, outMessage->length, outMessage->recipient, &flags)) {
+    outMessage->status = ControlMessageMeshQueued;
+    return true;
+  }
+  return false;
+}
+
+bool ControlMode::isRecipientNearby (const char* recipient) {
+  uint8_t nearby[OUTBOUND_NEARBY_LOOKUP];
+  uint8_t nearbyCount = chatter->getPingTable()->loadNearbyDevices(PingQualityGood, nearby, OUTBOUND_NEARBY_LOOKUP, 90);
+  for (uint8_t i = 0; i < nearbyCount; i++) {
+    chatter->loadDeviceId(nearby[i], meshDevIdBuffer);
+    if (memcmp(meshDevIdBuffer, recipient, CHATTER_DEVICE_ID_SIZE) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ControlMode::handleInboundMessage (const MessageView& inbound) {
+  // a retransmit of something already handled means our ack was lost. ack it again, but don't run it twice
+  bool duplicate = !inbound.isAck && recentMessages.checkAndRemember(inbound.sender, inbound.messageId, millis());
+  if (duplicate) {
+    sprintf(logBuffer, "Duplicate %s from %s, re-ack only (%lu dups)", inbound.messageId, inbound.sender, recentMessages.getHitCount());
+    Logger::info(logBuffer, LogAppControl);
+  }
+
+  // hold the ack until the receive burst is drained
+  if (!inbound.isAck && inbound.addressedToUs) {
+    AckQueueResult ackResult = ackQueue.queueAck(inbound.sender, inbound.messageId, activeTraceId);
+    if (ackResult == AckQueued) {
+      latencyTracer.expect(activeTraceId);
+    }
+    else if (ackResult == AckQueueFull) {
+      // no room to defer, send it now
+      latencyTracer.expect(activeTraceId);
+      sendAck(inbound.sender, inbound.messageId, activeTraceId);
+    }
+  }
+
+  if (duplicate) {
+    return;
+  }
+
+  // if it's a command, execute it
+  if (inbound.getType() == MessageTypeControl && isRemoteCommand(inbound.data, inbound.length)) {
+    // in node, remote commands are always enabled
+    //if (preferenceHandler->isPreferenceEnabled(PreferenceRemoteConfigEnabled)) {
+      sprintf(logBuffer, "Executing command: %c from %s", inbound.data[4], inbound.sender);
+      Logger::warn(logBuffer, LogAppControl);
+      executeRemoteCommand(inbound);
+      latencyTracer.executed(activeTraceId);
+    //}
+    //else {
+    //  Logger::warn("Received remote command, but not enabled on this device!", LogAppControl);
+    //}
+  }
+  else {
+    ((ChatterViewCallback*)globalCallbackRegistry->getCallback(CallbackChatStatus))->messageReceived();
+  }
+}
+
+bool ControlMode::sendAck (const char* recipient, const char* messageId, uint16_t traceId) {
+  Logger::debug("sending ack..", LogAppControl);
+  if (chatter->sendAck(recipient, messageId)) {
+    ackQueue.ackSent(false);
+    latencyTracer.ackSent(traceId);
+    return true;
+  }
+
+  Logger::debug("Ack direct failed", LogAppControl);
+  if (chatter->isMeshEnabled() && chatter->sendAckViaMesh(recipient, messageId)) {
+    ackQueue.ackSent(true);
+    latencyTracer.ackSent(traceId);
+    return true;
+  }
+
+  ackQueue.ackFailed();
+  latencyTracer.ackSent(traceId); // nothing more will happen for it
+  return false;
+}
+
+// sends every deferred ack, returns how many went out
+uint8_t ControlMode::flushAcks () {
+  uint8_t acksSent = 0;
+  if (ackQueue.isEmpty()) {
+    return 0;
+  }
+
+  outboundQueue.recordDepth(OutboundPriorityAck, ackQueue.getCount());
+  while (!ackQueue.isEmpty()) {
+    PendingAck* ack = ackQueue.peek();
+    outboundQueue.recordAttempt(OutboundPriorityAck, millis() - ack->queuedAt);
+    if (sendAck(ack->recipient, ack->messageId, ack->traceId)) {
+      acksSent++;
+    }
+    ackQueue.pop();
+  }
+
+  outboundQueue.recordDepth(OutboundPriorityAck, 0);
+
+  if (acksSent > 0) {
+    sprintf(logBuffer, "Acks sent: %lu, failed: %lu, coalesced: %lu, recv slots recovered: %lu", ackQueue.getSentCount() + ackQueue.getMeshCount(), ackQueue.getFailedCount(), ackQueue.getCoalescedCount(), ackQueue.getSlotsRecovered());
+    Logger::debug(logBuffer, LogAppControl);
+  }
+
+  return acksSent;
 }
 
 // does an immediate factory reset
@@ -537,45 +821,131 @@ void ControlMode::factoryReset () {
 }
 
 bool ControlMode::flushStorage () {
-  bool flushHappened = false;
+  uint8_t flushed = 0;
+
+  if (timers->consume(TimerStorageFlush)) {
+    flushed = flushScheduler.flushDue(this, millis());
+    if (flushed > 0) {
+      flushScheduler.writeSummary(logBuffer, sizeof(logBuffer));
+      Logger::debug(logBuffer, LogAppControl);
+    }
+  }
+
+  scheduleStorageFlushes();
+
+  return flushed > 0;
+}
+
+bool ControlMode::flushZone (uint8_t zone) {
+  sprintf(logBuffer, "flushing zone %d", zone);
+  Logger::info(logBuffer, LogAppControl);
+  chatter->flushStorage((StorageZone)zone);
+  return checkFlushed(zone);
+}
+
+// chatter's flush doesn't report failure, but a zone it couldn't write is still dirty.
+// nothing else can dirty it in between, the caller holds chatter
+bool ControlMode::checkFlushed (uint8_t zone) {
+  if (chatter->isStorageDirty((StorageZone)zone)) {
+    sprintf(logBuffer, "Zone %d still dirty after flush", zone);
+    Logger::warn(logBuffer, LogStorage);
+    storageSession.reportError();
+    return false;
+  }
+  return true;
+}
+
+uint8_t ControlMode::journalStorageFlushes () {
+  uint8_t journaled = 0;
   unsigned long now = millis();
 
+  // whatever the writer finished since last cycle
+  StorageWriteResult result;
+  bool anyWritten = false;
+  while (storageWriter.nextResult(result)) {
+    if (result.written) {
+      anyWritten = true;
+      // lateness as the radio sees it, journal time included
+      flushScheduler.recordFlush(result.zone, now, result.writeMicros);
+      sprintf(logBuffer, "Zone %d written in %lu us (%lu ms in journal), radio stall max %lu us", result.zone, result.writeMicros, result.queuedMillis, storageWriter.getMaxStallMicros());
+      Logger::info(logBuffer, LogAppControl);
+    }
+    else {
+      // try again after another delay
+      flushScheduler.reschedule(result.zone, now);
+    }
+  }
+  if (anyWritten) {
+    flushScheduler.writeSummary(logBuffer, sizeof(logBuffer));
+    Logger::debug(logBuffer, LogAppControl);
+  }
 
-  // start with a random zone, and look until we find a dirty one to flush
-  // or until we've checked all zones
-  uint8_t currZone = random(0, CHATTER_STORAGE_ZONE_COUNT);
-  uint8_t zonesChecked = 0;
-  while (zonesChecked < CHATTER_STORAGE_ZONE_COUNT && flushHappened == false) {
-    zonesChecked++;
-    if (nextFlush[currZone] != 0 && now > nextFlush[currZone]) {
-      if (chatter->isStorageDirty((StorageZone)currZone)) {
-        sprintf(logBuffer, "flushing zone %d", currZone);
-        Logger::info(logBuffer, LogAppControl);
-        if (openStorage()) {
-          chatter->flushStorage((StorageZone)currZone);
-          closeStorage();
-          nextFlush[currZone] = 0;
-          flushHappened = true;
-        }
-        else {
-          Logger::warn("Storage unavailable for flush", LogAppControl);
-        }
+  if (timers->consume(TimerStorageFlush)) {
+    // the journal is written in order, so hand zones over earliest deadline first
+    uint8_t due[CHATTER_STORAGE_ZONE_COUNT];
+    uint8_t dueCount = flushScheduler.collectDue(now, due);
+    for (uint8_t i = 0; i < dueCount; i++) {
+      uint8_t zone = due[i];
+      if (storageWriter.isPending(zone)) {
+        continue;
+      }
+      if (!chatter->isStorageDirty((StorageZone)zone)) {
+        // was already written out some other way
+        flushScheduler.clear(zone);
+      }
+      else if (storageWriter.request(zone)) {
+        journaled++;
       }
     }
   }
 
+  scheduleStorageFlushes();
+  return journaled;
+}
+
+bool ControlMode::writeStorageJournal () {
+  StorageWriteRequest* request = storageWriter.nextRequest();
+  if (request == nullptr || !storageWriter.canComplete()) {
+    return false;
+  }
+
+  storageWriter.setWriting(true);
+  housekeepingStalls.enter(StallPhaseFlush);
+  unsigned long writeStart = micros();
+  bool written = true;
+  if (chatter->isStorageDirty((StorageZone)request->zone)) {
+    if (openStorage()) {
+      chatter->flushStorage((StorageZone)request->zone);
+      written = checkFlushed(request->zone);
+      closeStorage();
+    }
+    else {
+      Logger::warn("Storage unavailable for flush", LogAppControl);
+      written = false;
+    }
+  }
+  storageWriter.setWriting(false);
+  housekeepingStalls.exit(StallPhaseFlush);
+
+  return storageWriter.completeRequest(written, micros() - writeStart);
+}
+
+void ControlMode::scheduleStorageFlushes () {
+  unsigned long now = millis();
+
   // check each zone to see if another flush should be scheduled
   for (uint8_t zone = 0; zone < CHATTER_STORAGE_ZONE_COUNT; zone++) {
-    if (nextFlush[zone] == 0) {
-      if (chatter->isStorageDirty((StorageZone)zone)) {
-        sprintf(logBuffer, "Scheduled for flush: %d (in %lu millis)", zone, now + flushDelay[zone]);
-        Logger::info(logBuffer, LogAppControl);
-        nextFlush[zone] = now + flushDelay[zone];
-      }
+    if (!flushScheduler.isScheduled(zone) && chatter->isStorageDirty((StorageZone)zone)) {
+      flushScheduler.schedule(zone, now);
+      sprintf(logBuffer, "Scheduled for flush: %d (in %lu millis)", zone, flushScheduler.getDelay(zone));
+      Logger::info(logBuffer, LogAppControl);
     }
-  }
 
-  return flushHappened;
+    // the wheel only needs to know about the earliest one, a journaled zone is already handled
+    if (flushScheduler.isScheduled(zone) && !storageWriter.isPending(zone)) {
+      timers->scheduleEarliest(TimerStorageFlush, flushScheduler.getDeadline(zone));
+    }
+  }
 }
 
 void ControlMode::showTime () {
@@ -587,7 +957,32 @@ void ControlMode::showTime () {
  * Miscellaneous *
  *****************/
 void ControlMode::sleepOrBackground(unsigned long sleepTime) {
-  delay(sleepTime);
+  if (idleScheduler.idleFor(sleepTime)) {
+    Logger::debug("Radio ended idle", LogAppControl);
+  }
+}
+
+void ControlMode::reportStalls () {
+  reportStalls(&loopStalls, "loop");
+  reportStalls(&housekeepingStalls, "housekeeping");
+}
+
+void ControlMode::reportStalls (StallMonitor* monitor, const char* taskName) {
+  StallPhase phase;
+  unsigned long iterationMicros;
+  unsigned long phaseMicros;
+  if (monitor->takeStall(phase, iterationMicros, phaseMicros)) {
+    sprintf(logBuffer, "Stall: %s took %lu ms, %s %lu ms (%lu stalls, worst %s %lu ms)", taskName, iterationMicros / 1000,
+      StallMonitor::getPhaseName(phase), phaseMicros / 1000, monitor->getStallCount(), StallMonitor::getPhaseName(phase), monitor->getWorstMicros(phase) / 1000);
+    Logger::warn(logBuffer, LogAppControl);
+  }
+}
+
+bool ControlMode::hasPendingWork () {
+  // anything waiting on a schedule is on the timer wheel, only ready work counts here
+  return !ackQueue.isEmpty() || outboundQueue.hasReady() ||
+    restartQueued || factoryResetQueued || changePasswordQueued || meshResetQueued || meshPacketClearQueued ||
+    onboardState != OnboardIdle;
 }
 
 bool ControlMode::initializeNewDevice (DeviceInitializationForm* initializationForm) {
@@ -655,6 +1050,25 @@ bool ControlMode::initializeNewDevice (DeviceInitializationForm* initializationF
 }
 
 bool ControlMode::getGpsCoords (double& latitude, double& longitude) {
+  const LocationFix& fix = locationSampler.getLatest();
+  if (fix.valid) {
+    latitude = fix.latitude;
+    longitude = fix.longitude;
+    return true;
+  }
+  return false;
+}
+
+bool ControlMode::refreshGpsCoords () {
+  if (!timers->isIdle(TimerGpsRefresh) && !timers->consume(TimerGpsRefresh)) {
+    return false;
+  }
+  timers->schedule(TimerGpsRefresh, gpsRefreshDelay);
+
+  LocationFix fix;
+  memset(&fix, 0, sizeof(fix));
+  fix.sampledAt = millis();
+
   if (rtc->getGnssEnabled() == false) {
     // check if prefs have it enabled
     // it may have become disabled due to low battery
@@ -664,39 +1078,36 @@ bool ControlMode::getGpsCoords (double& latitude, double& longitude) {
         rtc->setGnssEnabled(true);
       }
     }
-
-    return false;
   }
   else if (((int)getBatteryLevel()) < 20) {
     // turn off gps to save battery
     // will come back on when charge threshold is passed
     Logger::warn("Charge has fallen below threshold, gps disabled", LogLocation);
     rtc->setGnssEnabled(false);
-    return false; 
   }
-
-  showStatus("GPS");
-  if (rtc->getGpsIsValid()) {
-    latitude = rtc->getLatitude();
-    longitude = rtc->getLongitude();
-    
-    float heading = 0.0;
-    float speed = 0.0;
-
-    float altitude = rtc->getGpsAltitude();
-    if (rtc->getCourseIsValid()) {
-        heading = rtc->getCourseHeading();
-    }
-    if (rtc->getSpeedIsValid()) {
-        speed = rtc->getSpeed();
+  else {
+    fix.gnssEnabled = true;
+    if (rtc->getGpsIsValid()) {
+      fix.valid = true;
+      fix.latitude = rtc->getLatitude();
+      fix.longitude = rtc->getLongitude();
+      fix.altitude = rtc->getGpsAltitude();
+      fix.epoch = rtc->getEpoch();
+      if (rtc->getCourseIsValid()) {
+        fix.heading = rtc->getCourseHeading();
+      }
+      if (rtc->getSpeedIsValid()) {
+        fix.speed = rtc->getSpeed();
+      }
     }
-
-    chatter->getLocationStore()->updateLocation(chatter->getDeviceId(), rtc->getEpoch(), latitude, longitude, altitude, heading, speed, LocationDeviceMediumPrecision);
-
-    return true;
   }
 
-  return false;
+  // the store only hears about real movement, or a stationary fix once it gets old
+  if (locationSampler.publish(fix)) {
+    chatter->getLocationStore()->updateLocation(chatter->getDeviceId(), fix.epoch, fix.latitude, fix.longitude, fix.altitude, fix.heading, fix.speed, LocationDeviceMediumPrecision);
+    locationSampler.markStored(fix);
+  }
+  return true;
 }
 
 void ControlMode::restartDevice() {
@@ -758,42 +1169,43 @@ TimeZoneValue ControlMode::getTimeZoneFor (const char* tzName) {
   return TZ_NY;
 }
 
-bool ControlMode::factoryResetButtonHeld() {
+void ControlMode::watchFactoryResetButton () {
   #ifdef FACTORY_RESET_PIN
-  // check if factory rest button being held
-  if (!digitalRead(FACTORY_RESET_PIN)) {
-    showStatus("Factory Reset...");
-
-    // pin needs to be held down for 3 seconds
-    int resetMillis = 10000;
-    bool held = true;
-    for (uint8_t timerCount = 0; held && timerCount < resetMillis / 250; timerCount++) {
-      Logger::warn("Button held, factory reset countdown", LogAppControl);
-      held = !digitalRead(FACTORY_RESET_PIN);
-      delay(250);
-    }
-    if (held) {
-      Logger::warn("Factory reset by button upon startup", LogAppControl);
-      return true;
-    }
-  }
+  runtime->start(&factoryResetHold);
   #endif
+}
 
-  return false;
+void ControlMode::stepFactoryResetHold (StepTask* task, unsigned long now) {
+  #ifdef FACTORY_RESET_PIN
+  // pin needs to be held down for 10 seconds, checked every 250 ms
+  const uint8_t resetChecks = 10000 / 250;
+  bool held = !digitalRead(FACTORY_RESET_PIN);
 
+  if (!held) {
+    // released (or never pressed), nothing to do
+    task->finish();
+  }
+  else if (task->getStage() >= resetChecks) {
+    Logger::warn("Factory reset by button upon startup", LogAppControl);
+    factoryReset();
+    task->finish();
+  }
+  else {
+    if (task->getStage() == 0) {
+      showStatus("Factory Reset...");
+    }
+    Logger::warn("Button held, factory reset countdown", LogAppControl);
+    task->setStage(task->getStage() + 1);
+    task->sleepFor(now, 250);
+  }
+  #else
+  task->finish();
+  #endif
 }
 
-// close sd card resources , if they are currently open
+// ends the storage session, the mount is kept
 bool ControlMode::closeStorage () {
-  /*#if !defined(CORE_TEENSY) // END not supported on teensy?!?
-  if (storageOpen == true) {
-    Logger::info("Closing storage", LogAppControl);
-    SD.end(); 
-    Logger::info("Storage is closed", LogAppControl);
-    storageOpen = false;
-  }
-  #endif
-  */
+  storageSession.close();
   return true;
 }
 
@@ -803,7 +1215,7 @@ bool ControlMode::wipeStorage () {
   char fullFolderName[64];
 
   // delete every file before the current
-  char* rootFolder = "/fram/chatter";
+  const char* rootFolder = STORAGE_ROOT;
 
   for (uint8_t folderNum = 0; folderNum < 12; folderNum++) {
     sprintf(fullFolderName, "%s/%d", rootFolder, folderNum);    
@@ -843,74 +1255,293 @@ bool ControlMode::wipeStorage () {
   return true;
 }
 
-// open sd card resources. Does nothing if already open
-bool ControlMode::openStorage ()  {
-  if (!storageOpen) {
-    Logger::info("Opening storage", LogAppControl);
-    if (SD.begin(sdPin, *sdSpiClass)) {
-        uint8_t cardType = SD.cardType();
-        if (cardType == CARD_NONE) {
-            Logger::warn("No SD card attached", LogStorage);
-            return false;
-        } 
-        else {
-            Logger::info("Storage is open", LogAppControl);
-            storageOpen = true;
-        }
+bool ControlMode::moveStorageToTrash () {
+  if (!openStorage()) {
+    return false;
+  }
+  if (!SD.exists(STORAGE_TRASH_ROOT) && !SD.mkdir(STORAGE_TRASH_ROOT)) {
+    Logger::warn("Trash folder unavailable, wiping in place", LogAppControl);
+    return false;
+  }
+
+  // an earlier reset may still be in the trash
+  char trashFolder[64];
+  uint8_t generation = 0;
+  do {
+    sprintf(trashFolder, "%s/%d", STORAGE_TRASH_ROOT, generation++);
+  } while (SD.exists(trashFolder) && generation < 100);
+
+  // the keys and headers go first, so what's moved can't be opened again
+  unsigned long moveStart = millis();
+  uint8_t scrubbed = scrubStorageRoot();
+  if (!SD.rename(STORAGE_ROOT, trashFolder)) {
+    Logger::warn("Storage couldn't be moved to trash, wiping in place", LogAppControl);
+    return false;
+  }
+
+  sprintf(logBuffer, "%d top level files overwritten, storage moved to %s in %lu ms, deleted after restart", scrubbed, trashFolder, millis() - moveStart);
+  Logger::warn(logBuffer, LogAppControl);
+  return true;
+}
+
+uint8_t ControlMode::scrubStorageRoot () {
+  File root = SD.open(STORAGE_ROOT);
+  if (!root) {
+    return 0;
+  }
+
+  uint8_t zeros[STORAGE_SCRUB_CHUNK];
+  memset(zeros, 0, STORAGE_SCRUB_CHUNK);
+  char path[64];
+  uint8_t scrubbed = 0;
+  while (true) {
+    File entry = root.openNextFile();
+    if (!entry) {
+      break;
+    }
+    bool isFile = !entry.isDirectory();
+    size_t size = entry.size();
+    snprintf(path, sizeof(path), "%s/%s", STORAGE_ROOT, entry.name());
+    entry.close();
+    if (!isFile) {
+      // zone folders, left for the trash
+      continue;
+    }
+
+    File target = SD.open(path, "r+");
+    if (target) {
+      for (size_t written = 0; written < size; written += STORAGE_SCRUB_CHUNK) {
+        target.write(zeros, size - written < STORAGE_SCRUB_CHUNK ? size - written : STORAGE_SCRUB_CHUNK);
+      }
+      target.flush();
+      target.close();
+    }
+
+    // and truncate, so not even the length survives
+    File truncated = SD.open(path, FILE_WRITE);
+    if (truncated) {
+      truncated.close();
+      scrubbed++;
     }
     else {
-        Logger::error("Open storage failed!", LogAppControl);
+      Logger::error("Failed to overwrite: ", path, LogAppControl);
+      storageSession.reportError();
     }
   }
+  root.close();
+  return scrubbed;
+}
+
+bool ControlMode::emptyTrashStep (StallMonitor* stalls) {
+  if (!trashPending) {
+    return true;
+  }
+  if (!TimerWheel::deadlineReached(millis(), trashRetryAt) || !openStorage()) {
+    return false;
+  }
+
+  stalls->enter(StallPhasePrune);
+  uint8_t budget = STORAGE_TRASH_STEP_ENTRIES;
+  unsigned long removedBefore = trashRemoved;
+  trashStepFailures = 0;
+  trashPending = !removeTree(STORAGE_TRASH_ROOT, budget);
+  closeStorage();
+  stalls->exit(StallPhasePrune);
+
+  if (trashPending && trashRemoved == removedBefore) {
+    // only entries that won't delete are left, the rest are gone. try those less often
+    sprintf(logBuffer, "Trash entries failing to delete (%lu failures), retry in %lu ms", trashFailures, trashBackoff);
+    Logger::warn(logBuffer, LogAppControl);
+    trashRetryAt = millis() + trashBackoff;
+    trashBackoff = trashBackoff * 2 < STORAGE_TRASH_RETRY_MAX ? trashBackoff * 2 : STORAGE_TRASH_RETRY_MAX;
+    return false;
+  }
+  trashBackoff = STORAGE_TRASH_RETRY_MIN;
+
+  if (!trashPending) {
+    sprintf(logBuffer, "Trash emptied, %lu entries removed", trashRemoved);
+    Logger::info(logBuffer, LogAppControl);
+  }
+  return !trashPending;
+}
+
+void ControlMode::skipTrashEntry (uint8_t& budget) {
+  trashFailures++;
+  if (++trashStepFailures >= STORAGE_TRASH_STEP_FAILURES) {
+    // this pass has spent long enough on entries that won't go
+    budget = 0;
+  }
+}
+
+// depth first, each file or folder removed costs one from the budget. an entry that
+// won't delete is skipped (up to STORAGE_TRASH_STEP_FAILURES a pass), so the rest of the tree still goes
+bool ControlMode::removeTree (const char* path, uint8_t& budget) {
+  if (!storageSession.ready()) {
+    // a reported error unmounted the card, an open would fail and look like the entry was gone
+    return false;
+  }
+
+  File entry = SD.open(path);
+  if (!entry) {
+    return true;
+  }
+
+  if (!entry.isDirectory()) {
+    entry.close();
+    if (budget == 0) {
+      return false;
+    }
+    if (!SD.remove(path)) {
+      Logger::error("Failed to remove: ", path, LogAppControl);
+      storageSession.reportError();
+      skipTrashEntry(budget);
+      return false;
+    }
+    budget--;
+    trashRemoved++;
+    return true;
+  }
+
+  char childPath[64];
+  bool childLeft = false;
+  while (budget > 0) {
+    File child = entry.openNextFile();
+    if (!child) {
+      entry.close();
+      if (childLeft) {
+        // the folder can't go until what's in it does
+        return false;
+      }
+      if (!SD.rmdir(path)) {
+        Logger::warn("Failed to remove directory: ", path, LogAppControl);
+        storageSession.reportError();
+        skipTrashEntry(budget);
+        return false;
+      }
+      budget--;
+      trashRemoved++;
+      return true;
+    }
+    snprintf(childPath, sizeof(childPath), "%s/%s", path, child.name());
+    child.close();
+    if (!removeTree(childPath, budget)) {
+      childLeft = true;
+    }
+  }
+
+  entry.close();
+  return false;
+}
 
-  return storageOpen;
+// the card stays mounted, this only mounts if it isn't (or is due a retry)
+bool ControlMode::openStorage ()  {
+  return storageSession.open();
 }
 
 
 void ControlMode::joinCluster () {
-  while (true) {
-    continueJoining();
+  if (onboardState == OnboardIdle) {
+    Logger::info("Starting onboard", LogOnboard);
+    onboardState = OnboardStarting;
+    updateChatProgress(0.0);
   }
 }
 
-void ControlMode::continueJoining () {
-    if (joiningInitialized == false) {
-        if (assistant == nullptr) {
-            assistant = new ChatterClusterAssistant(chatter, LORA_CS, LORA_INT, LORA_RS, LORA_BUSY, false, STRONG_ENCRYPTION_ENABLED);
-        }
-        if(assistant->init()) {
-            assistant->beginOnboarding();
-            joiningInitialized = true;
-            Logger::info("Joining initialized", LogUi);
-        }
+// one step of onboarding per control cycle, the radio belongs to the assistant until the restart
+OnboardState ControlMode::stepJoining () {
+    switch (onboardState) {
+        case OnboardStarting:
+            if (!timers->isIdle(TimerOnboard) && !timers->consume(TimerOnboard)) {
+                // waiting to retry init
+                break;
+            }
+            if (assistant == nullptr) {
+                assistant = new ChatterClusterAssistant(chatter, LORA_CS, LORA_INT, LORA_RS, LORA_BUSY, false, STRONG_ENCRYPTION_ENABLED);
+            }
+            if(assistant->init()) {
+                assistant->beginOnboarding();
+                onboardState = OnboardWaitingConnect;
+                Logger::info("Joining initialized", LogUi);
+                updateChatStatus("Waiting for Connect");
+                updateChatProgress(0.2);
+            }
+            else {
+                Logger::warn("Onboard assistant init failed, retrying", LogOnboard);
+                timers->schedule(TimerOnboard, ONBOARD_INIT_RETRY_DELAY);
+            }
+            break;
+        case OnboardWaitingConnect:
+        case OnboardInProgress:
+            // step forward in onboard
+            assistant->onboardNextStep();
+
+            if (assistant->isOnboardComplete()) {
+                completeJoining();
+            }
+            else if (assistant->isConnected() == false) {
+                if (onboardState == OnboardInProgress) {
+                    Logger::warn("Admin disconnected during onboard", LogOnboard);
+                    timers->cancel(TimerOnboard);
+                    onboardState = OnboardWaitingConnect;
+                    updateChatStatus("Waiting for Connect");
+                    updateChatProgress(0.2);
+                }
+            }
+            else if (onboardState == OnboardWaitingConnect) {
+                // the admin has this long to get the cluster info across
+                onboardState = OnboardInProgress;
+                timers->schedule(TimerOnboard, CLUSTER_ONBOARD_TIMEOUT);
+                updateChatStatus("Onboarding...");
+                updateChatProgress(0.5);
+            }
+            else if (timers->consume(TimerOnboard)) {
+                // exchange stalled part way through, start over
+                onboardTimeouts++;
+                sprintf(logBuffer, "Onboard timed out after %d ms (%d so far), restarting", CLUSTER_ONBOARD_TIMEOUT, onboardTimeouts);
+                Logger::warn(logBuffer, LogOnboard);
+                assistant->beginOnboarding();
+                onboardState = OnboardWaitingConnect;
+                updateChatStatus("Onboard timed out");
+                updateChatProgress(0.2);
+            }
+            break;
+        default:
+            // idle, or just waiting on the restart
+            break;
+    }
+
+    return onboardState;
+}
+
+void ControlMode::completeJoining () {
+    timers->cancel(TimerOnboard);
+
+    // since joining a new cluster, clear the mesh/ping info to make
+    // room for the new cluster's data
+    chatter->getDeviceStore()->setClearMeshOnStartup(true);
+
+    // save the changes
+    flushStorage();
+
+    delete assistant;
+    assistant = nullptr;
+
+    // restart to join new cluster
+    Logger::info("Join is complete, restarting...", LogUi);
+    updateChatStatus("Joined; Restarting....");
+    updateChatProgress(1.0);
+    onboardState = OnboardComplete;
+    runtime->start(&joinRestart);
+}
+
+void ControlMode::stepJoinRestart (StepTask* task, unsigned long now) {
+    if (task->getStage() == 0) {
+        task->setStage(1);
+        task->sleepFor(now, 5000);
     }
     else {
-        // step forward in onbaord
-        assistant->onboardNextStep();
-        bool isConnected = assistant->isConnected();
-        bool isComplete = assistant->isOnboardComplete();
-        bool isTrying = assistant->isOnboardingInProgress();
-
-        if (isConnected == false) {
-          updateChatStatus("Waiting for Connect");
-        }
-        else if (isComplete) {
-            // since joining a new cluster, clear the mesh/ping info to make
-            // room for the new cluster's data
-            chatter->getDeviceStore()->setClearMeshOnStartup(true);
-
-            // save the changes
-            flushStorage();
-
-            delete assistant;
-            assistant = nullptr;
-
-            // restart to join new cluster
-            Logger::info("Join is complete, restarting...", LogUi);
-            updateChatStatus("Joined; Restarting....");
-            delay(5000);
-            restartDevice();
-        }
+        task->finish();
+        restartDevice();
     }
 }
 
@@ -930,13 +1561,14 @@ float ControlMode::getBatteryLevel() {
   return 100.0;
 }
 
-bool ControlMode::executeRemoteCommand (uint8_t* message, const char* requestor) {
-  switch (message[4]) {
+bool ControlMode::executeRemoteCommand (const MessageView& command) {
+  const char* requestor = command.sender;
+  switch (command.data[4]) {
     case RemoteCommandLocationDisable:
       Logger::info("Requested to disable location: ", requestor, LogAppControl);
       preferenceHandler->disablePreference(PreferenceGnssEnabled);
       preferenceHandler->disablePreference(PreferenceLocationSharingEnabled);
-      queueOutMessage((uint8_t*)"GNSS and location sharing DISABLED", 34, requestor, 500);
+      queueOutMessage((uint8_t*)"GNSS and location sharing DISABLED", 34, requestor, 500, OutboundPriorityControl);
 
       return true;
 
@@ -944,7 +1576,7 @@ bool ControlMode::executeRemoteCommand (uint8_t* message, const char* requestor)
       Logger::info("Requested to enable location: ", requestor, LogAppControl);
       preferenceHandler->enablePreference(PreferenceGnssEnabled);
       preferenceHandler->enablePreference(PreferenceLocationSharingEnabled);
-      queueOutMessage((uint8_t*)"GNSS and location sharing ENABLED", 33, requestor, 500);
+      queueOutMessage((uint8_t*)"GNSS and location sharing ENABLED", 33, requestor, 500, OutboundPriorityControl);
 
       return true;
 
@@ -953,44 +1585,85 @@ bool ControlMode::executeRemoteCommand (uint8_t* message, const char* requestor)
       if (BACKPACK_RELAY_ENABLED) {
         for (uint8_t i = 0; i < numBackpacks; i++) {
           if (backpacks[i]->getType() == BackpackTypeRelay) {
-            if(backpacks[i]->handleMessage (message, strlen((char*)message), requestor, chatter->getDeviceId())) {
-              queueOutMessage((uint8_t*)"Relay triggered", 15, requestor, 500);
+            if(backpacks[i]->handleMessage (command.data, command.length, requestor, chatter->getDeviceId())) {
+              queueOutMessage((uint8_t*)"Relay triggered", 15, requestor, 500, OutboundPriorityControl);
               return true;
             }
           }
         }
 
-        queueOutMessage((uint8_t*)"Relay NOT triggered", 19, requestor, 500);
+        queueOutMessage((uint8_t*)"Relay NOT triggered", 19, requestor, 500, OutboundPriorityControl);
 
       }
       else {
-        queueOutMessage((uint8_t*)"No relay onboard", 16, requestor, 500);
+        queueOutMessage((uint8_t*)"No relay onboard", 16, requestor, 500, OutboundPriorityControl);
       }
       return true;
 
     case RemoteCommandBattery:
       // grab the battery level
-      sprintf((char*)messageBuffer, "%s %03d", "Battery:", getBatteryLevel());
+      sprintf((char*)replyBuffer, "%s %03d", "Battery:", (int)getBatteryLevel());
       Logger::info("RC Sending battery level to: ", requestor, LogAppControl);
 
       // send to requestor
-      queueOutMessage(messageBuffer, strlen((char*)messageBuffer), requestor, 500);
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
       return true;
     case RemoteCommandUptime:
-      sprintf((char*)messageBuffer, "Uptime: %d min", (millis() / 1000)/60);
+      snprintf((char*)replyBuffer, sizeof(replyBuffer), "Uptime: %lu min, rx budget %d/%d, dups %lu (%d%%), active %d%% (save %d%%)", (unsigned long)(millis() / 1000)/60, receiveBudget.getReadBudget(), receiveBudget.getPollCount(false), recentMessages.getHitCount(), recentMessages.getHitRatePercent(), idleScheduler.getActivePercent(), idleScheduler.getProjectedSavingsPercent());
       Logger::info("RC Sending uptime to: ", requestor, LogAppControl);
 
       // send to requestor
-      queueOutMessage(messageBuffer, strlen((char*)messageBuffer), requestor, 500);
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
+      return true;
+    case RemoteCommandLatency:
+      {
+        int summaryLength = clampReplyLength(latencyTracer.writeSummary((char*)replyBuffer, CONTROL_REPLY_BUFFER_SIZE + 1));
+        summaryLength = clampReplyLength(summaryLength + snprintf((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength, "\n"));
+        outboundQueue.writeSummary((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength);
+      }
+      Logger::info("RC Sending latency to: ", requestor, LogAppControl);
+
+      // send to requestor
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
+      return true;
+    case RemoteCommandStalls:
+      {
+        int summaryLength = sprintf((char*)replyBuffer, "Stalls loop ");
+        summaryLength = clampReplyLength(summaryLength + loopStalls.writeSummary((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength));
+        summaryLength = clampReplyLength(summaryLength + snprintf((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength, "\nhk "));
+        housekeepingStalls.writeSummary((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength);
+      }
+      Logger::info("RC Sending stalls to: ", requestor, LogAppControl);
+
+      // send to requestor
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
+      return true;
+    case RemoteCommandStorage:
+      {
+        int summaryLength = clampReplyLength(storageSession.writeSummary((char*)replyBuffer, CONTROL_REPLY_BUFFER_SIZE + 1));
+        summaryLength = clampReplyLength(summaryLength + snprintf((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength, ", prunes %lu (worst %lu ms)\n", pruneCount, worstPruneMillis));
+        flushScheduler.writeSummary((char*)replyBuffer + summaryLength, CONTROL_REPLY_BUFFER_SIZE + 1 - summaryLength);
+      }
+      Logger::info("RC Sending storage to: ", requestor, LogAppControl);
+
+      // send to requestor
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
+      return true;
+    case RemoteCommandTimers:
+      timers->writeSummary((char*)replyBuffer, CONTROL_REPLY_BUFFER_SIZE + 1);
+      Logger::info("RC Sending timers to: ", requestor, LogAppControl);
+
+      // send to requestor
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
       return true;
     case RemoteCommandNeighbors:
       rcNeighborCount = chatter->getPingTable()->loadNearbyDevices (PingQualityBad, rcNeighbors, 10, 90);
-      char* pos = (char*)messageBuffer;
+      memset(replyBuffer, 0, CONTROL_REPLY_BUFFER_SIZE + 1);
+      char* pos = (char*)replyBuffer;
       const char* neighborsPrefix = "Neighbors: ";
       memcpy(pos, neighborsPrefix, strlen(neighborsPrefix));
       pos += strlen(neighborsPrefix);
 
-      memset(messageBuffer, 0, GUI_MESSAGE_BUFFER_SIZE);
       for (uint8_t i = 0; i < rcNeighborCount; i++) {
         if (i > 0){
           memcpy(pos, ", ", 2);
@@ -1016,7 +1689,7 @@ bool ControlMode::executeRemoteCommand (uint8_t* message, const char* requestor)
       Logger::info("RC neighbors to: ", requestor, LogAppControl);
 
       // send to requestor
-      queueOutMessage(messageBuffer, strlen((char*)messageBuffer), requestor, 500);
+      queueOutMessage(replyBuffer, strlen((char*)replyBuffer), requestor, 500, OutboundPriorityControl);
       return true;
   }
 
@@ -1028,9 +1701,9 @@ bool ControlMode::executeRemoteCommand (uint8_t* message, const char* requestor)
 void ControlMode::populateMeshPath (const char* recipientId) {
   meshPathLength = chatter->findMeshPath (chatter->getDeviceId(), recipientId, meshPath);
 
-  // copy the path into the message buffer so we can display
-  memset(messageBuffer, 0, GUI_MAX_MESSAGE_LENGTH+1);
-  uint8_t* pos = messageBuffer;
+  // copy the path into the reply buffer so we can display
+  memset(replyBuffer, 0, CONTROL_REPLY_BUFFER_SIZE + 1);
+  uint8_t* pos = replyBuffer;
 
   if (meshPathLength > 0) {
     for (uint8_t p = 0; p < meshPathLength; p++) {
@@ -16,6 +16,20 @@
 #include <XPowersLib.h>
 #include "../backpacks/relay/RelayBackpack.h"
 #include "../backpacks/Backpack.h"
+#include "OutboundQueue.h"
+#include "AckQueue.h"
+#include "RecentMessageFilter.h"
+#include "ReceiveBudget.h"
+#include "LocationSampler.h"
+#include "FlushScheduler.h"
+#include "StorageWriter.h"
+#include "StorageSession.h"
+#include "MessageView.h"
+#include "../tasks/TimerWheel.h"
+#include "../tasks/StepRuntime.h"
+#include "../tasks/IdleScheduler.h"
+#include "../telemetry/LatencyTracer.h"
+#include "../telemetry/StallMonitor.h"
 
 #ifndef CONTROL_MODE_H
 #define CONTROL_MODE_H
@@ -56,33 +70,42 @@ enum StartupState {
   StartupDeviceStoreReady = 9
 };
 
-enum ControlMessageState {
-  ControlMessageNew = 0,
-  ControlMessageScheduled = 1,
-  ControlMessageSendingDirect = 2,
-  ControlMessageSendingMesh = 3,
-  ControlMessageSentDirect = 4,
-  ControlMessageMeshQueued = 5,
-  ControlMessageFailed = 6,
-  ControlMessageCancelled = 7,
-  ControlMessageUnknown = 8
-};
-
 enum ControlCycleType {
   ControlCycleResponsive = 0,
-  ControlCycleFull = 1
+  ControlCycleFull = 1,
+  ControlCycleRadio = 2 // full cycle minus storage and gps, the housekeeping task does those
 };
 
+enum OnboardState {
+  OnboardIdle = 0, // not joining a cluster
+  OnboardStarting = 1, // assistant being initialized
+  OnboardWaitingConnect = 2, // waiting on an admin device
+  OnboardInProgress = 3, // admin connected, exchanging cluster info
+  OnboardComplete = 4 // joined, restart pending
+};
+
+#define ONBOARD_INIT_RETRY_DELAY 1000 // wait between assistant init attempts
 #define STORAGE_PRUNE_DELAY 60000*10 // 10 min
-#define CHATTER_POLL_COUNT_PER_CYCLE_RESPONSIVE 2
-#define CHATTER_POLL_COUNT_PER_CYCLE_FULL 10
+#define STORAGE_PRUNE_STARTUP_DELAY 30000 // the prune boot used to force runs this long after startup instead
+#define STORAGE_PRUNE_MAX_DEFER 60000 // a due prune waits for a cycle without pending work at most this long
+#define STORAGE_PRUNE_RUNNING 'P' // kept in StoredPrefPruneState while a prune is underway, only reported
+#define STORAGE_PRUNE_COMPLETE 'C'
+#define STORAGE_ROOT "/fram/chatter"
+#define STORAGE_TRASH_ROOT "/fram/trash" // reset storage trees waiting to be deleted, one numbered folder each
+#define STORAGE_TRASH_STEP_ENTRIES 8 // files and folders deleted per storage cycle
+#define STORAGE_TRASH_STEP_FAILURES 16 // failed deletes skipped per cycle before giving up on it
+#define STORAGE_TRASH_RETRY_MIN 10000 // when only entries that failed to delete are left, wait this long
+#define STORAGE_TRASH_RETRY_MAX 600000 // doubling stops here
+#define STORAGE_SCRUB_CHUNK 64 // zeros written per call when overwriting the top level files
+#define OUTBOUND_NEARBY_LOOKUP 10 // how many good ping table entries to check for a direct recipient
+#define CONTROL_REPLY_BUFFER_SIZE 255 // remote command replies (neighbors, mesh path) are built here
 
 /**
  * Base class for the different control modes available for this vehicle.
  */
-class ControlMode : public ChatStatusCallback, public BackupCallback, public LicenseCallback, public StorageStatusCallback, public BasicControl {
+class ControlMode : public ChatStatusCallback, public BackupCallback, public LicenseCallback, public StorageStatusCallback, public FlushBackend, public BasicControl {
   public:
-    ControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu);
+    ControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, TimerWheel* _timers, StepRuntime* _runtime, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu);
 
     /** initialization methods **/
     virtual StartupState initEncryptedStorage();
@@ -95,6 +118,7 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
     /** end init methods **/
 
     virtual void processOneCycle(ControlCycleType cycleType);
+    bool processHousekeeping(); // pruning and gps work, returns true if storage was written
 
     virtual void showStatus (const char* status);
 
@@ -162,33 +186,56 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
     bool verifyPassword (const char* password);
 
     void setListeningForMessages(bool _listening) { listeningForMessages = _listening; }
+    // the last sampled fix, no gps or pmu traffic
     bool getGpsCoords (double& latitude, double& longitude);
-    //bool refreshGpsCoords ();
+    LocationSampler* getLocationSampler () { return &locationSampler; }
 
     const char* getViewableTime() {return rtc->getViewableTime();}
 
-    ControlMessageState getOutMessageStatus () { return outMessageStatus; }
-    void cancelOutMessage () { outMessageStatus = ControlMessageCancelled; }
-    void queueOutMessage (uint8_t* newMessage, int newMessageLength, const char* recipient, unsigned long scheduledDelay);
-    void queueOutBroadcast (uint8_t* newMessage, int newMessageLength, unsigned long scheduledDelay);
+    ControlMessageState getOutMessageStatus () { return outboundQueue.getLastStatus(); }
+    void cancelOutMessage () { outboundQueue.cancelLast(); }
+    bool queueOutMessage (uint8_t* newMessage, int newMessageLength, const char* recipient, unsigned long scheduledDelay, OutboundPriority priority = OutboundPriorityUser);
+    bool queueOutBroadcast (uint8_t* newMessage, int newMessageLength, unsigned long scheduledDelay);
 
     // queues a packet clearing
     void clearMeshPackets ();
     void clearMessages ();
 
     bool flushStorage (); // flushes if it's time
-    bool closeStorage (); // close sd card resources
-    bool openStorage (); // open sd card resources. Does nothing if already open
+
+    // FlushBackend, one session covers every zone flushStorage finds overdue
+    bool isZoneDirty (uint8_t zone) { return chatter->isStorageDirty((StorageZone)zone); }
+    bool openFlushSession () { return openStorage(); }
+    bool flushZone (uint8_t zone);
+    bool checkFlushed (uint8_t zone); // false (and reported to the storage session) if the flush didn't take
+    void closeFlushSession () { closeStorage(); }
+    void scheduleStorageFlushes (); // arms the flush timer for any newly dirty zones
+    uint8_t journalStorageFlushes (); // radio side: hands due zones to the storage writer, picks up what it finished
+    bool writeStorageJournal (); // housekeeping side: writes the oldest journaled zone, false if nothing was written
+    StorageWriter* getStorageWriter () { return &storageWriter; }
+    bool closeStorage (); // ends a storage session, the card stays mounted
+    bool openStorage (); // starts a storage session, mounting the card if it isn't
     bool wipeStorage ();
+    bool moveStorageToTrash (); // fast reset, the tree is gone from chatter's view in one rename
+    uint8_t scrubStorageRoot (); // overwrites and truncates the files directly under STORAGE_ROOT
 
     // does an immediate factory reset
     void factoryReset ();
-    void joinCluster();
+    void joinCluster(); // starts onboarding, processOneCycle steps it until the restart
 
     PreferenceHandler* getPreferenceHandler () { return preferenceHandler; }
+    IdleScheduler* getIdleScheduler () { return &idleScheduler; }
+    StallMonitor* getLoopStalls () { return &loopStalls; }
+    StallMonitor* getHousekeepingStalls () { return &housekeepingStalls; }
+    void reportStalls (); // logs any stall since the last call
+
+    // anything the next cycle should do right away, rather than after an idle
+    bool hasPendingWork ();
+    virtual void sleepOrBackground(unsigned long sleepTime);
 
   protected:
-    bool executeRemoteCommand (uint8_t* message, const char* requestor);
+    void handleInboundMessage (const MessageView& inbound);
+    bool executeRemoteCommand (const MessageView& command);
     void populateMeshPath (const char* recipientId);
     bool isRemoteCommand (const uint8_t* msg, int msgLength);
     bool isBackpackRequest (const uint8_t* msg, int msgLength);
@@ -197,23 +244,28 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
     bool clearMeshPacketsIfQueued ();
     bool meshPacketClearQueued = false;
 
-    bool storageOpen = false; // storage will be opened during initialization automatically
-    uint8_t sdPin = 0;
-    SPIClass* sdSpiClass;
+    StorageSession storageSession; // one mount for the life of the node
     
     /** fields for handling messages **/
-    uint8_t messageBuffer[GUI_MESSAGE_BUFFER_SIZE+1];
-    int messageBufferLength = 0;
-    MessageType messageBufferType;
+    uint8_t replyBuffer[CONTROL_REPLY_BUFFER_SIZE+1];
+
+    // snprintf reports what it would have written, a reply built from several pieces
+    // keeps its length clamped so the next piece is never handed a negative size
+    int clampReplyLength (int length) { return length < 0 ? 0 : (length < CONTROL_REPLY_BUFFER_SIZE ? length : CONTROL_REPLY_BUFFER_SIZE); }
     char otherDeviceId[CHATTER_DEVICE_ID_SIZE+1];
     char otherClusterId[CHATTER_LOCAL_NET_ID_SIZE+CHATTER_GLOBAL_NET_ID_SIZE+1];
 
-    uint8_t outMessageBuffer[GUI_MESSAGE_BUFFER_SIZE + 1];
-    char outMessageRecipient[CHATTER_DEVICE_ID_SIZE+1];
-    int outMessageBufferLength = 0;
-    ControlMessageState outMessageStatus = ControlMessageUnknown;
-    MessageType outMessageBufferType;
-    unsigned long outMessageScheduledTime = 0;
+    OutboundQueue outboundQueue;
+    uint8_t processOutbound ();
+    bool sendOutbound (OutboundMessage* outMessage); // one attempt, retry policy picks the path
+    bool sendOutboundDirect (OutboundMessage* outMessage);
+    bool sendOutboundMesh (OutboundMessage* outMessage);
+    bool isRecipientNearby (const char* recipient);
+
+    AckQueue ackQueue;
+    RecentMessageFilter recentMessages; // catches retransmits of messages already handled
+    bool sendAck (const char* recipient, const char* messageId, uint16_t traceId);
+    uint8_t flushAcks ();
     /****/
 
     /** password stuff */
@@ -226,14 +278,22 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
     bool changePassword ();
     /****/
 
-    bool factoryResetButtonHeld ();
+    // starts watching the factory reset button, a 10 sec hold resets
+    void watchFactoryResetButton ();
+    void stepFactoryResetHold (StepTask* task, unsigned long now);
+    StepMethodTask<ControlMode> factoryResetHold;
 
     // miscellaneous
-    virtual void sleepOrBackground(unsigned long sleepTime);
+    IdleScheduler idleScheduler; // waits between cycles, keeps the duty cycle
     TimeZoneValue getTimeZoneFor (const char* tzName);
     bool listeningForMessages = false;
     bool controlModeInitializing = false;
-    uint8_t maxReadPacketsPerCycle = 5;
+    ReceiveBudget receiveBudget; // sizes each receive burst
+    LatencyTracer latencyTracer; // inbound message -> ack -> command -> reply timing
+    uint16_t activeTraceId = LATENCY_TRACE_NONE; // message being dispatched, replies queued now belong to it
+    StallMonitor loopStalls; // control layer iterations, radio side
+    StallMonitor housekeepingStalls; // housekeeping task passes
+    void reportStalls (StallMonitor* monitor, const char* taskName);
 
     RTClockBase* rtc;
     Chatter* chatter;
@@ -249,11 +309,15 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
 
     DeviceType deviceType;
     
-    unsigned long nextGpsRrefresh = 0;
+    TimerWheel* timers;
+    StepRuntime* runtime;
+
     unsigned long gpsRefreshDelay = 10000; // how often to refresh gps
+    LocationSampler locationSampler;
+    bool refreshGpsCoords (); // samples the fix if TimerGpsRefresh is due, true if it did
 
-    unsigned long nextFlush [CHATTER_STORAGE_ZONE_COUNT];
-    unsigned long flushDelay [CHATTER_STORAGE_ZONE_COUNT];
+    StorageWriter storageWriter; // write-behind flushes when the housekeeping task is running
+    FlushScheduler flushScheduler {CHATTER_STORAGE_ZONE_COUNT};
 
     bool restartQueued = false;
     bool factoryResetQueued = false;
@@ -263,8 +327,32 @@ class ControlMode : public ChatStatusCallback, public BackupCallback, public Lic
 
     bool meshResetQueued = false;
 
-    void continueJoining ();
-    bool joiningInitialized = false;
+    OnboardState stepJoining ();
+    void completeJoining ();
+    void maintainStorage (ControlCycleType cycleType); // flush/prune, or journal when housekeeping writes
+
+    // deferred prune: one whole chatter prune on whichever task owns storage, started when the radio is quiet
+    bool prunePending = false;
+    bool pruneForced = false;
+    unsigned long pruneDueAt = 0;
+    unsigned long pruneCount = 0;
+    unsigned long worstPruneMillis = 0;
+    bool pruneStorageIfDue (StallMonitor* stalls); // true if a prune ran
+
+    // whatever a fast reset left behind, deleted a little per cycle
+    bool trashPending = false;
+    unsigned long trashRemoved = 0;
+    unsigned long trashFailures = 0;
+    uint8_t trashStepFailures = 0;
+    unsigned long trashRetryAt = 0;
+    unsigned long trashBackoff = STORAGE_TRASH_RETRY_MIN;
+    bool emptyTrashStep (StallMonitor* stalls); // true once there's nothing left
+    bool removeTree (const char* path, uint8_t& budget); // false if anything under path is left
+    void skipTrashEntry (uint8_t& budget);
+    OnboardState onboardState = OnboardIdle;
+    uint16_t onboardTimeouts = 0; // exchanges that stalled and were restarted
+    void stepJoinRestart (StepTask* task, unsigned long now);
+    StepMethodTask<ControlMode> joinRestart; // leaves time to read the status before restarting
 
     uint8_t meshPath[CHATTER_MESH_MAX_HOPS];
     uint8_t meshPathLength = 0;
@@ -0,0 +1,122 @@
+#include "FlushScheduler.h"
+
+FlushScheduler::FlushScheduler (uint8_t _zoneCount, FlushClock _clock) {
+  zoneCount = _zoneCount < FLUSH_MAX_ZONES ? _zoneCount : FLUSH_MAX_ZONES;
+  clock = _clock;
+  memset(deadlines, 0, sizeof(deadlines));
+  memset(delays, 0, sizeof(delays));
+  memset(stats, 0, sizeof(stats));
+}
+
+bool FlushScheduler::schedule (uint8_t zone, unsigned long now) {
+  if (isScheduled(zone)) {
+    return false;
+  }
+  reschedule(zone, now);
+  return true;
+}
+
+void FlushScheduler::reschedule (uint8_t zone, unsigned long now) {
+  deadlines[zone] = now + delays[zone];
+  scheduledMask |= (1 << zone);
+}
+
+uint8_t FlushScheduler::collectDue (unsigned long now, uint8_t* zones) {
+  uint8_t count = 0;
+  for (uint8_t zone = 0; zone < zoneCount; zone++) {
+    if (!isScheduled(zone) || (long)(now - deadlines[zone]) < 0) {
+      continue;
+    }
+
+    // insertion sort on how overdue each one is, a handful of zones at most
+    long overdue = (long)(now - deadlines[zone]);
+    uint8_t pos = count;
+    while (pos > 0 && (long)(now - deadlines[zones[pos - 1]]) < overdue) {
+      zones[pos] = zones[pos - 1];
+      pos--;
+    }
+    zones[pos] = zone;
+    count++;
+  }
+  return count;
+}
+
+uint8_t FlushScheduler::flushDue (FlushBackend* backend, unsigned long now) {
+  uint8_t due[FLUSH_MAX_ZONES];
+  uint8_t dueCount = collectDue(now, due);
+
+  // zones that were written out some other way don't need the session
+  uint8_t dirtyCount = 0;
+  for (uint8_t i = 0; i < dueCount; i++) {
+    if (backend->isZoneDirty(due[i])) {
+      due[dirtyCount++] = due[i];
+    }
+    else {
+      clear(due[i]);
+    }
+  }
+  if (dirtyCount == 0) {
+    return 0;
+  }
+
+  if (!backend->openFlushSession()) {
+    for (uint8_t i = 0; i < dirtyCount; i++) {
+      reschedule(due[i], now);
+    }
+    return 0;
+  }
+
+  sessions++;
+  unsigned long sessionStart = clock();
+  uint8_t written = 0;
+  for (uint8_t i = 0; i < dirtyCount; i++) {
+    unsigned long elapsed = clock() - sessionStart;
+    if (written > 0 && elapsed >= budgetMicros) {
+      // the rest are still overdue, they go first next time
+      budgetStops++;
+      break;
+    }
+
+    unsigned long writeStart = clock();
+    if (!backend->flushZone(due[i])) {
+      // try again after another delay
+      reschedule(due[i], now);
+      continue;
+    }
+    recordFlush(due[i], now + elapsed / 1000ul, clock() - writeStart);
+    written++;
+  }
+  backend->closeFlushSession();
+
+  return written;
+}
+
+void FlushScheduler::recordFlush (uint8_t zone, unsigned long now, unsigned long writeMicros) {
+  FlushZoneStats* zoneStats = &stats[zone];
+  long lateness = isScheduled(zone) ? (long)(now - deadlines[zone]) : 0;
+  if (lateness < 0) {
+    lateness = 0;
+  }
+
+  zoneStats->flushes++;
+  zoneStats->totalLatenessMillis += lateness;
+  if ((unsigned long)lateness > zoneStats->worstLatenessMillis) {
+    zoneStats->worstLatenessMillis = lateness;
+  }
+  zoneStats->totalWriteMicros += writeMicros;
+  if (writeMicros > zoneStats->worstWriteMicros) {
+    zoneStats->worstWriteMicros = writeMicros;
+  }
+  clear(zone);
+}
+
+int FlushScheduler::writeSummary (char* buffer, int maxLength) {
+  int pos = snprintf(buffer, maxLength, "Flush sessions %lu (%lu over budget), late avg/worst ms:", sessions, budgetStops);
+  for (uint8_t zone = 0; zone < zoneCount && pos < maxLength; zone++) {
+    FlushZoneStats* zoneStats = &stats[zone];
+    if (zoneStats->flushes > 0) {
+      pos += snprintf(buffer + pos, maxLength - pos, " %d:%lu/%lu", zone, zoneStats->totalLatenessMillis / zoneStats->flushes, zoneStats->worstLatenessMillis);
+    }
+  }
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,82 @@
+#include "../tasks/TaskPlatform.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef FLUSHSCHEDULER_H
+#define FLUSHSCHEDULER_H
+
+#define FLUSH_MAX_ZONES 16 // masks are 16 bits, plenty for the chatter zones
+#define FLUSH_DEFAULT_BUDGET_MILLIS 250 // no new zone is started once a session has run this long
+
+typedef unsigned long (*FlushClock) ();
+
+// where the zones actually get written, the control mode in the sketch
+class FlushBackend {
+  public:
+    virtual bool isZoneDirty (uint8_t zone) = 0;
+    virtual bool openFlushSession () = 0;
+    virtual bool flushZone (uint8_t zone) = 0; // false if the zone couldn't be written
+    virtual void closeFlushSession () = 0;
+};
+
+struct FlushZoneStats {
+  unsigned long flushes;
+  unsigned long totalLatenessMillis; // how long past its deadline the zone was written
+  unsigned long worstLatenessMillis;
+  unsigned long totalWriteMicros;
+  unsigned long worstWriteMicros;
+};
+
+/**
+ * Flush deadlines for the storage zones. A zone gets a deadline its flush
+ * delay after it first turns dirty, and overdue zones are written earliest
+ * deadline first, as many as fit in the budget of one storage session.
+ * Whatever doesn't fit stays overdue and leads the next session.
+ */
+class FlushScheduler {
+  public:
+    FlushScheduler (uint8_t _zoneCount, FlushClock _clock = TaskPlatform::nowMicros);
+
+    void setDelay (uint8_t zone, unsigned long delayMillis) { delays[zone] = delayMillis; }
+    unsigned long getDelay (uint8_t zone) { return delays[zone]; }
+    void setBudget (unsigned long budgetMillis) { budgetMicros = budgetMillis * 1000ul; }
+    unsigned long getBudget () { return budgetMicros / 1000ul; }
+
+    // gives a newly dirty zone its deadline, false if it already had one
+    bool schedule (uint8_t zone, unsigned long now);
+    void reschedule (uint8_t zone, unsigned long now); // a write failed, wait another delay
+    void clear (uint8_t zone) { scheduledMask &= ~(1 << zone); }
+    bool isScheduled (uint8_t zone) { return (scheduledMask & (1 << zone)) != 0; }
+    unsigned long getDeadline (uint8_t zone) { return deadlines[zone]; }
+
+    // overdue zones, earliest deadline first. returns how many went into zones
+    uint8_t collectDue (unsigned long now, uint8_t* zones);
+
+    // writes the overdue zones in one session, returns how many were written
+    uint8_t flushDue (FlushBackend* backend, unsigned long now);
+
+    // a zone written somewhere else (the storage journal), clears it as well
+    void recordFlush (uint8_t zone, unsigned long now, unsigned long writeMicros);
+
+    FlushZoneStats* getZoneStats (uint8_t zone) { return &stats[zone]; }
+    unsigned long getSessionCount () { return sessions; }
+    unsigned long getBudgetStops () { return budgetStops; }
+
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    uint8_t zoneCount;
+    FlushClock clock;
+    unsigned long budgetMicros = FLUSH_DEFAULT_BUDGET_MILLIS * 1000ul;
+
+    uint16_t scheduledMask = 0;
+    unsigned long deadlines[FLUSH_MAX_ZONES];
+    unsigned long delays[FLUSH_MAX_ZONES];
+    FlushZoneStats stats[FLUSH_MAX_ZONES];
+
+    unsigned long sessions = 0;
+    unsigned long budgetStops = 0; // sessions that left overdue zones for the next one
+};
+
+#endif
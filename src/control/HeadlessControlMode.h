@@ -7,7 +7,7 @@
 
 class HeadlessControlMode : public ControlMode {
     public:
-        HeadlessControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu) : ControlMode(_deviceType, _rtc, _callbackRegistry, _sdPin, _sdSpiClass, _pmu) {}
+        HeadlessControlMode (DeviceType _deviceType, RTClockBase* _rtc, CallbackRegistry* _callbackRegistry, TimerWheel* _timers, StepRuntime* _runtime, uint8_t _sdPin, SPIClass & _sdSpiClass, XPowersLibInterface* _pmu) : ControlMode(_deviceType, _rtc, _callbackRegistry, _timers, _runtime, _sdPin, _sdSpiClass, _pmu) {}
 
         // these methods need converted to callback approach
         uint8_t promptForPassword (char* passwordBuffer, uint8_t maxPasswordLength);
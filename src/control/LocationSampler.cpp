@@ -0,0 +1,57 @@
+#include "LocationSampler.h"
+
+LocationSampler::LocationSampler () {
+  memset(&latest, 0, sizeof(latest));
+  memset(&stored, 0, sizeof(stored));
+}
+
+bool LocationSampler::publish (const LocationFix& fix) {
+  latest = fix;
+  samples++;
+
+  if (!fix.valid) {
+    return false;
+  }
+  if (!storedValid) {
+    return true;
+  }
+
+  if ((unsigned long)(fix.sampledAt - stored.sampledAt) >= LOCATION_STORE_MAX_AGE) {
+    return true;
+  }
+  if (distanceMeters(stored.latitude, stored.longitude, fix.latitude, fix.longitude) >= LOCATION_STORE_MIN_METERS) {
+    return true;
+  }
+  if (fix.speed >= LOCATION_STORE_MIN_SPEED && headingDelta(stored.heading, fix.heading) >= LOCATION_STORE_MIN_HEADING) {
+    return true;
+  }
+  return false;
+}
+
+void LocationSampler::markStored (const LocationFix& fix) {
+  stored = fix;
+  storedValid = true;
+  stores++;
+}
+
+// equirectangular, plenty at the distances the threshold cares about
+float LocationSampler::distanceMeters (double lat1, double lng1, double lat2, double lng2) {
+  double toRadians = M_PI / 180.0;
+  double x = (lng2 - lng1) * toRadians * cos((lat1 + lat2) * 0.5 * toRadians);
+  double y = (lat2 - lat1) * toRadians;
+  return (float)(sqrt(x*x + y*y) * LOCATION_EARTH_RADIUS);
+}
+
+float LocationSampler::headingDelta (float heading1, float heading2) {
+  float delta = fabsf(heading2 - heading1);
+  while (delta >= 360.0f) {
+    delta -= 360.0f;
+  }
+  return delta > 180.0f ? 360.0f - delta : delta;
+}
+
+int LocationSampler::writeSummary (char* buffer, int maxLength) {
+  int pos = snprintf(buffer, maxLength, "Gps %lu samples, %lu stored, fix %s",
+    samples, stores, latest.valid ? "valid" : (latest.gnssEnabled ? "searching" : "off"));
+  return pos < maxLength ? pos : maxLength - 1;
+}
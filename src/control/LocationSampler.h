@@ -0,0 +1,61 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef LOCATIONSAMPLER_H
+#define LOCATIONSAMPLER_H
+
+#define LOCATION_STORE_MIN_METERS 25 // moved at least this far since the stored fix
+#define LOCATION_STORE_MIN_HEADING 30 // degrees of turn, only counted while moving
+#define LOCATION_STORE_MIN_SPEED 1.0 // below this the course is noise
+#define LOCATION_STORE_MAX_AGE 300000 // a stationary fix is still re-stored this often
+#define LOCATION_EARTH_RADIUS 6371000.0
+
+struct LocationFix {
+  bool gnssEnabled;
+  bool valid;
+  double latitude;
+  double longitude;
+  float altitude;
+  float heading;
+  float speed;
+  uint32_t epoch;
+  unsigned long sampledAt;
+};
+
+/**
+ * Holds the latest gps fix for anything that wants to show it, and decides
+ * whether a fix has moved far enough from the last stored one to be worth
+ * a location store write. Sampling itself is driven by the control mode.
+ */
+class LocationSampler {
+  public:
+    LocationSampler ();
+
+    // replaces the snapshot, returns true if the fix should also go to the location store
+    bool publish (const LocationFix& fix);
+
+    // call once the store write went through
+    void markStored (const LocationFix& fix);
+
+    const LocationFix& getLatest () { return latest; }
+
+    unsigned long getSampleCount () { return samples; }
+    unsigned long getStoreCount () { return stores; }
+
+    int writeSummary (char* buffer, int maxLength);
+
+    static float distanceMeters (double lat1, double lng1, double lat2, double lng2);
+    static float headingDelta (float heading1, float heading2);
+
+  protected:
+    LocationFix latest;
+    LocationFix stored;
+    bool storedValid = false;
+
+    unsigned long samples = 0;
+    unsigned long stores = 0;
+};
+
+#endif
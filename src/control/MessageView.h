@@ -0,0 +1,25 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "ChatterAll.h"
+
+#ifndef MESSAGEVIEW_H
+#define MESSAGEVIEW_H
+
+/**
+ * Read-only view of the message chatter just retrieved. The payload still
+ * lives in chatter's receive buffer, so it is only valid until the next
+ * retrieveMessage. Anything that needs the data later must copy it out first.
+ */
+struct MessageView {
+  const uint8_t* data;
+  int length;
+  const char* sender; // null terminated
+  const char* messageId;
+  ChatterMessageFlags flags;
+  bool isAck;
+  bool addressedToUs;
+
+  MessageType getType () const { return (MessageType)flags.Flag0; }
+};
+
+#endif
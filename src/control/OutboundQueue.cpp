@@ -0,0 +1,211 @@
+#include "OutboundQueue.h"
+
+OutboundQueue::OutboundQueue () {
+  for (uint8_t i = 0; i < OUTBOUND_QUEUE_SIZE; i++) {
+    entries[i].length = 0;
+    entries[i].status = ControlMessageUnknown;
+    entries[i].scheduledTime = 0;
+  }
+
+  policy.maxAttempts = OUTBOUND_RETRY_MAX_ATTEMPTS;
+  policy.directAttemptsNear = OUTBOUND_RETRY_DIRECT_NEAR;
+  policy.directAttemptsFar = OUTBOUND_RETRY_DIRECT_FAR;
+  policy.backoffBase = OUTBOUND_RETRY_BACKOFF_BASE;
+  policy.backoffMax = OUTBOUND_RETRY_BACKOFF_MAX;
+
+  weights[OutboundPriorityAck] = 0; // acks never come through here
+  weights[OutboundPriorityControl] = OUTBOUND_WEIGHT_CONTROL;
+  weights[OutboundPriorityUser] = OUTBOUND_WEIGHT_USER;
+  weights[OutboundPriorityBulk] = OUTBOUND_WEIGHT_BULK;
+  memcpy(credits, weights, sizeof(credits));
+  memset(classStats, 0, sizeof(classStats));
+}
+
+bool OutboundQueue::enqueue (const uint8_t* message, int messageLength, const char* recipient, bool isBroadcast, MessageType type, unsigned long scheduledDelay, OutboundPriority priority, uint16_t traceId) {
+  if (messageLength > GUI_MAX_MESSAGE_LENGTH) {
+    Logger::warn("Outbound message too long, dropped", LogAppControl);
+    return false;
+  }
+
+  // make sure count and depth are current before checking for room
+  reclaim();
+
+  int8_t slot = -1;
+  for (uint8_t i = 0; i < OUTBOUND_QUEUE_SIZE && slot < 0; i++) {
+    if (isTerminal(entries[i].status)) {
+      slot = i;
+    }
+  }
+
+  if (slot < 0 || classStats[priority].depth >= getSlotLimit(priority)) {
+    Logger::warn("Outbound queue full, message dropped", LogAppControl);
+    return false;
+  }
+
+  OutboundMessage* entry = &entries[slot];
+  memcpy(entry->buffer, message, messageLength);
+  entry->buffer[messageLength] = 0;
+  entry->length = messageLength;
+  snprintf(entry->recipient, CHATTER_DEVICE_ID_SIZE+1, "%s", recipient);
+  entry->isBroadcast = isBroadcast;
+  entry->type = type;
+  entry->status = ControlMessageNew;
+  entry->scheduledTime = millis() + scheduledDelay;
+  entry->traceId = traceId;
+  entry->attempts = 0;
+  entry->directAttempts = 0;
+  entry->priority = priority;
+  entry->sequence = nextSequence++;
+
+  lastQueued = slot;
+  count++;
+  if (++classStats[priority].depth > classStats[priority].maxDepth) {
+    classStats[priority].maxDepth = classStats[priority].depth;
+  }
+  return true;
+}
+
+uint8_t OutboundQueue::reclaim () {
+  uint8_t previousCount = count;
+  count = 0;
+  for (uint8_t p = OutboundPriorityControl; p < OUTBOUND_PRIORITY_COUNT; p++) {
+    classStats[p].depth = 0;
+  }
+
+  for (uint8_t i = 0; i < OUTBOUND_QUEUE_SIZE; i++) {
+    if (!isTerminal(entries[i].status)) {
+      count++;
+      classStats[entries[i].priority].depth++;
+    }
+  }
+  return previousCount > count ? previousCount - count : 0;
+}
+
+uint8_t OutboundQueue::getSlotLimit (OutboundPriority priority) {
+  switch (priority) {
+    case OutboundPriorityUser:
+      return OUTBOUND_SLOTS_USER;
+    case OutboundPriorityBulk:
+      return OUTBOUND_SLOTS_BULK;
+    default:
+      return OUTBOUND_QUEUE_SIZE;
+  }
+}
+
+OutboundMessage* OutboundQueue::selectNext () {
+  // second pass only happens when every class with something ready has used its credits
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (uint8_t p = OutboundPriorityControl; p < OUTBOUND_PRIORITY_COUNT; p++) {
+      if (credits[p] == 0) {
+        continue;
+      }
+
+      OutboundMessage* oldest = nullptr;
+      for (uint8_t i = 0; i < OUTBOUND_QUEUE_SIZE; i++) {
+        if (entries[i].status == ControlMessageScheduled && entries[i].priority == p && (oldest == nullptr || (long)(entries[i].sequence - oldest->sequence) < 0)) {
+          oldest = &entries[i];
+        }
+      }
+
+      if (oldest != nullptr) {
+        credits[p]--;
+        return oldest;
+      }
+    }
+
+    // start a new round
+    memcpy(credits, weights, sizeof(credits));
+  }
+  return nullptr;
+}
+
+bool OutboundQueue::hasReadyAbove (OutboundPriority priority) {
+  for (uint8_t i = 0; i < OUTBOUND_QUEUE_SIZE; i++) {
+    if (entries[i].status == ControlMessageScheduled && entries[i].priority < priority) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OutboundQueue::recordDepth (OutboundPriority priority, uint8_t depth) {
+  classStats[priority].depth = depth;
+  if (depth > classStats[priority].maxDepth) {
+    classStats[priority].maxDepth = depth;
+  }
+}
+
+void OutboundQueue::recordAttempt (OutboundPriority priority, unsigned long waitMillis) {
+  OutboundClassStats* stats = &classStats[priority];
+  stats->sent++;
+  if (waitMillis > stats->maxWait) {
+    stats->maxWait = waitMillis;
+  }
+  if (stats->sent == 1) {
+    stats->avgWait = waitMillis;
+  }
+  else {
+    stats->avgWait = stats->avgWait - (stats->avgWait >> 3) + (waitMillis >> 3);
+  }
+}
+
+int OutboundQueue::writeSummary (char* buffer, int maxLength) {
+  const char* classNames[OUTBOUND_PRIORITY_COUNT] = {"ack", "ctl", "usr", "blk"};
+  int pos = snprintf(buffer, maxLength, "Queue depth/max wait avg/max ms");
+  for (uint8_t p = 0; p < OUTBOUND_PRIORITY_COUNT && pos < maxLength; p++) {
+    pos += snprintf(buffer + pos, maxLength - pos, " %s:%d/%d %lu/%lu",
+      classNames[p], classStats[p].depth, classStats[p].maxDepth, classStats[p].avgWait, classStats[p].maxWait);
+  }
+  return pos < maxLength ? pos : maxLength - 1;
+}
+
+bool OutboundQueue::isTerminal (ControlMessageState state) {
+  switch (state) {
+    case ControlMessageSentDirect:
+    case ControlMessageMeshQueued:
+    case ControlMessageFailed:
+    case ControlMessageCancelled:
+    case ControlMessageUnknown:
+      return true;
+    default:
+      return false;
+  }
+}
+
+ControlMessageState OutboundQueue::getLastStatus () {
+  if (lastQueued < 0) {
+    return ControlMessageUnknown;
+  }
+  return entries[lastQueued].status;
+}
+
+void OutboundQueue::cancelLast () {
+  if (lastQueued >= 0 && !isTerminal(entries[lastQueued].status)) {
+    // sends are synchronous, so anything not finished is waiting and can be dropped
+    entries[lastQueued].status = ControlMessageCancelled;
+  }
+}
+
+bool OutboundQueue::attemptFailed (OutboundMessage* entry, unsigned long now) {
+  entry->attempts++;
+  if (entry->attempts >= policy.maxAttempts) {
+    entry->status = ControlMessageFailed;
+    return false;
+  }
+
+  entry->scheduledTime = now + getBackoff(entry->attempts);
+  return true;
+}
+
+unsigned long OutboundQueue::getBackoff (uint8_t attempts) {
+  unsigned long backoff = policy.backoffBase;
+  for (uint8_t i = 1; i < attempts && backoff < policy.backoffMax; i++) {
+    backoff <<= 1;
+  }
+  if (backoff > policy.backoffMax) {
+    backoff = policy.backoffMax;
+  }
+
+  // anywhere in the upper half, so nodes that collided don't collide again
+  return backoff / 2 + random(backoff / 2 + 1);
+}
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "../globals/Globals.h"
+#include "ChatterAll.h"
+
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+// each entry carries a whole gui message (~1.07 KB with its fields), so 4 take ~4.3 KB of RAM,
+// against the one 1 KB outMessageBuffer this replaced
+#define OUTBOUND_QUEUE_SIZE 4 // how many outbound messages can be pending at once
+#define OUTBOUND_MAX_SENDS_PER_CYCLE 3 // how many radio sends the queue may do in one control cycle
+
+#define OUTBOUND_RETRY_MAX_ATTEMPTS 5 // direct + mesh (or broadcast) attempts before a message fails
+#define OUTBOUND_RETRY_DIRECT_NEAR 3 // direct attempts when the ping table shows the recipient nearby
+#define OUTBOUND_RETRY_DIRECT_FAR 1 // direct attempts before going to mesh otherwise
+#define OUTBOUND_RETRY_BACKOFF_BASE 250 // ms after the first failure, doubles each retry
+#define OUTBOUND_RETRY_BACKOFF_MAX 8000 // ms, backoff never grows past this
+
+#define OUTBOUND_WEIGHT_CONTROL 4 // sends per round for command replies
+#define OUTBOUND_WEIGHT_USER 2 // sends per round for user messages
+#define OUTBOUND_WEIGHT_BULK 1 // sends per round for broadcasts
+#define OUTBOUND_SLOTS_USER 3 // slots user messages may hold, the rest is kept for replies
+#define OUTBOUND_SLOTS_BULK 2 // slots broadcasts may hold
+
+enum ControlMessageState {
+  ControlMessageNew = 0,
+  ControlMessageScheduled = 1,
+  ControlMessageSendingDirect = 2,
+  ControlMessageSendingMesh = 3,
+  ControlMessageSentDirect = 4,
+  ControlMessageMeshQueued = 5,
+  ControlMessageFailed = 6,
+  ControlMessageCancelled = 7,
+  ControlMessageUnknown = 8
+};
+
+// lower goes first. acks are held in the AckQueue and always go before any of these
+enum OutboundPriority {
+  OutboundPriorityAck = 0,
+  OutboundPriorityControl = 1,
+  OutboundPriorityUser = 2,
+  OutboundPriorityBulk = 3
+};
+
+#define OUTBOUND_PRIORITY_COUNT 4
+
+struct OutboundMessage {
+  uint8_t buffer[GUI_MESSAGE_BUFFER_SIZE + 1];
+  int length;
+  char recipient[CHATTER_DEVICE_ID_SIZE+1];
+  MessageType type;
+  bool isBroadcast;
+  ControlMessageState status;
+  unsigned long scheduledTime; // when the next attempt may go out
+  uint16_t traceId; // latency trace of the message this replies to, 0 if none
+  uint8_t attempts; // sends tried so far
+  uint8_t directAttempts; // how many of those may be direct, decided on the first attempt
+  OutboundPriority priority;
+  unsigned long sequence; // enqueue order, oldest goes first within a class
+};
+
+struct OutboundRetryPolicy {
+  uint8_t maxAttempts;
+  uint8_t directAttemptsNear;
+  uint8_t directAttemptsFar;
+  unsigned long backoffBase;
+  unsigned long backoffMax;
+};
+
+struct OutboundClassStats {
+  uint8_t depth; // messages of this class waiting right now
+  uint8_t maxDepth;
+  unsigned long sent; // attempts that went out
+  unsigned long avgWait; // ms from ready to first attempt, 1/8 smoothing
+  unsigned long maxWait;
+};
+
+/**
+ * Fixed slots of outbound messages, each carrying its own
+ * ControlMessageState. A slot is free again once its message reaches a
+ * terminal state. Ready messages are picked by priority class: each class
+ * gets its weight in sends per round, so replies are not stuck behind a long
+ * broadcast, but broadcasts still get a turn. A failed attempt is retried
+ * after an exponential, jittered backoff until the retry policy runs out of
+ * attempts.
+ */
+class OutboundQueue {
+  public:
+    OutboundQueue ();
+
+    // returns false (and drops the message) if it's too long or the class has no free slot
+    bool enqueue (const uint8_t* message, int messageLength, const char* recipient, bool isBroadcast, MessageType type, unsigned long scheduledDelay, OutboundPriority priority, uint16_t traceId = 0);
+
+    uint8_t getCount () { return count; }
+    bool isEmpty () { return count == 0; }
+
+    // slot index, the entry may be terminal (free)
+    OutboundMessage* getEntry (uint8_t slot) { return &entries[slot]; }
+
+    // the ready (Scheduled) message that should go next, null if none
+    OutboundMessage* selectNext ();
+    bool hasReadyAbove (OutboundPriority priority); // anything ready that outranks this class
+    bool hasReady () { return hasReadyAbove((OutboundPriority)OUTBOUND_PRIORITY_COUNT); }
+
+    // frees finished entries and refreshes the per class depth
+    uint8_t reclaim ();
+
+    bool isTerminal (ControlMessageState state);
+    ControlMessageState getLastStatus ();
+    void cancelLast ();
+
+    const OutboundRetryPolicy& getRetryPolicy () { return policy; }
+
+    // records a failed attempt, returns false if the message is out of attempts
+    bool attemptFailed (OutboundMessage* entry, unsigned long now);
+    unsigned long getBackoff (uint8_t attempts);
+
+    // the first attempt of a message is going out, waitMillis since it became due
+    void recordAttempt (OutboundPriority priority, unsigned long waitMillis);
+    void recordDepth (OutboundPriority priority, uint8_t depth); // for classes held outside this queue (acks)
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    OutboundMessage entries[OUTBOUND_QUEUE_SIZE];
+    uint8_t count = 0;
+    int8_t lastQueued = -1;
+    unsigned long nextSequence = 0;
+
+    OutboundRetryPolicy policy;
+
+    uint8_t weights[OUTBOUND_PRIORITY_COUNT];
+    uint8_t credits[OUTBOUND_PRIORITY_COUNT];
+    OutboundClassStats classStats[OUTBOUND_PRIORITY_COUNT];
+    uint8_t getSlotLimit (OutboundPriority priority);
+};
+
+#endif
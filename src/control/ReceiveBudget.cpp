@@ -0,0 +1,61 @@
+#include "ReceiveBudget.h"
+
+ReceiveBudget::ReceiveBudget () {
+}
+
+uint8_t ReceiveBudget::getPollCount (bool responsiveCycle) {
+  if (responsiveCycle) {
+    return min(pollCount, (uint8_t)RECEIVE_BUDGET_MIN_POLLS);
+  }
+  return pollCount;
+}
+
+void ReceiveBudget::update (uint8_t packetsRead, bool backlogged, unsigned long receiveMicros, uint8_t pendingOutbound) {
+  // running average of arrivals per burst
+  int arrivalsDelta = ((int)packetsRead << 4) - (int)arrivalsAvg;
+  arrivalsAvg = (uint16_t)((int)arrivalsAvg + (arrivalsDelta >> RECEIVE_BUDGET_AVG_SHIFT));
+
+  if (packetsRead > 0) {
+    unsigned long thisPacket = receiveMicros / packetsRead;
+    if (microsPerPacket == 0) {
+      microsPerPacket = thisPacket;
+    }
+    else {
+      long packetDelta = (long)thisPacket - (long)microsPerPacket;
+      microsPerPacket = (unsigned long)((long)microsPerPacket + (packetDelta >> RECEIVE_BUDGET_AVG_SHIFT));
+    }
+  }
+
+  int budget = readBudget;
+  if (backlogged) {
+    // there was more waiting when we stopped, grow
+    backloggedCycles++;
+    budget += 2;
+  }
+  else if ((arrivalsAvg >> 4) + 1 < budget) {
+    // traffic has dropped off, shrink slowly toward what we're seeing
+    budget -= 1;
+  }
+
+  // don't let a burst run past the cycle target
+  int timeCap = RECEIVE_BUDGET_MAX_READS;
+  if (microsPerPacket > 0) {
+    timeCap = (int)min(cycleTargetMicros / microsPerPacket, (unsigned long)RECEIVE_BUDGET_MAX_READS);
+    if (pendingOutbound > 0) {
+      // leave half the cycle for whatever is waiting to go out
+      timeCap = timeCap / 2;
+    }
+  }
+
+  budget = min(budget, timeCap);
+  readBudget = (uint8_t)max(min(budget, RECEIVE_BUDGET_MAX_READS), RECEIVE_BUDGET_MIN_READS);
+
+  // poll harder only while traffic is actually arriving
+  if (backlogged) {
+    pollCount = RECEIVE_BUDGET_MAX_POLLS;
+  }
+  else {
+    int polls = RECEIVE_BUDGET_MIN_POLLS + ((arrivalsAvg + 15) >> 4);
+    pollCount = (uint8_t)min(polls, RECEIVE_BUDGET_MAX_POLLS);
+  }
+}
@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifndef RECEIVEBUDGET_H
+#define RECEIVEBUDGET_H
+
+#define RECEIVE_BUDGET_MIN_READS 2
+#define RECEIVE_BUDGET_MAX_READS 16
+#define RECEIVE_BUDGET_DEFAULT_READS 5 // what the budget starts at, was the old fixed limit
+#define RECEIVE_BUDGET_MIN_POLLS 2
+#define RECEIVE_BUDGET_MAX_POLLS 10
+#define RECEIVE_CYCLE_TARGET_MILLIS 250 // how long one receive burst should take, at most
+#define RECEIVE_BUDGET_AVG_SHIFT 2 // averages move 1/4 of the way toward each new sample
+
+/**
+ * Sizes the per-cycle read budget and hasMessage poll count from what the
+ * radio has actually been doing. Bursts that hit the budget grow it, and the
+ * time per packet caps it so one cycle stays near the target. When the
+ * outbound side has work waiting, receive gives some of the cycle back.
+ */
+class ReceiveBudget {
+  public:
+    ReceiveBudget ();
+
+    uint8_t getReadBudget () { return readBudget; }
+    uint8_t getPollCount (bool responsiveCycle);
+
+    // called once per receive burst
+    void update (uint8_t packetsRead, bool backlogged, unsigned long receiveMicros, uint8_t pendingOutbound);
+
+    void setCycleTarget (unsigned long targetMillis) { cycleTargetMicros = targetMillis * 1000ul; }
+    unsigned long getCycleTarget () { return cycleTargetMicros / 1000ul; }
+
+    // telemetry
+    uint8_t getAverageArrivals () { return (arrivalsAvg + 8) >> 4; }
+    unsigned long getMicrosPerPacket () { return microsPerPacket; }
+    unsigned long getBackloggedCycles () { return backloggedCycles; }
+
+  protected:
+    uint8_t readBudget = RECEIVE_BUDGET_DEFAULT_READS;
+    uint8_t pollCount = RECEIVE_BUDGET_MAX_POLLS;
+    unsigned long cycleTargetMicros = RECEIVE_CYCLE_TARGET_MILLIS * 1000ul;
+
+    uint16_t arrivalsAvg = 0; // packets per burst, x16
+    unsigned long microsPerPacket = 0;
+    unsigned long backloggedCycles = 0;
+};
+
+#endif
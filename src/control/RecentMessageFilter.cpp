@@ -0,0 +1,30 @@
+#include "RecentMessageFilter.h"
+
+RecentMessageFilter::RecentMessageFilter () {
+  memset(slots, 0, sizeof(slots));
+}
+
+uint32_t RecentMessageFilter::fingerprint (const char* sender, const char* messageId) {
+  // over the fixed size sender and the id, with a separator so the split point counts
+  uint32_t hash = fnv1a(sender, CHATTER_DEVICE_ID_SIZE);
+  hash = fnv1aByte(hash, '|');
+  hash = fnv1a(messageId, RECENT_MESSAGE_ID_MAX, hash);
+  return hash == 0 ? 1 : hash;
+}
+
+bool RecentMessageFilter::checkAndRemember (const char* sender, const char* messageId, unsigned long now) {
+  checkCount++;
+
+  uint32_t print = fingerprint(sender, messageId);
+  // low bits pick the slot, the whole fingerprint confirms the match
+  RecentMessage* slot = &slots[(print ^ (print >> 16)) & (RECENT_MESSAGE_SLOTS - 1)];
+
+  if (slot->fingerprint == print && now - slot->seenAt < RECENT_MESSAGE_TTL) {
+    hitCount++;
+    return true;
+  }
+
+  slot->fingerprint = print;
+  slot->seenAt = now;
+  return false;
+}
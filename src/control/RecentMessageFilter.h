@@ -0,0 +1,44 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "ChatterAll.h"
+#include "../globals/Fnv1a.h"
+
+#ifndef RECENTMESSAGEFILTER_H
+#define RECENTMESSAGEFILTER_H
+
+#define RECENT_MESSAGE_SLOTS 32 // must be a power of two
+#define RECENT_MESSAGE_TTL 120000 // 2 min, a retransmit after this is treated as new
+#define RECENT_MESSAGE_ID_MAX 8 // room for the chatter message id
+
+/**
+ * Remembers sender + message id of recently dispatched messages in a
+ * direct-mapped table of fingerprints. A retransmit of a message we already
+ * handled (our ack was lost) shows up as a hit, so it can be re-acked without
+ * being executed again. Entries age out after RECENT_MESSAGE_TTL, and a newer
+ * message that maps to the same slot simply replaces the old one.
+ */
+class RecentMessageFilter {
+  public:
+    RecentMessageFilter ();
+
+    // true if this sender + id was seen within the ttl, otherwise it is remembered
+    bool checkAndRemember (const char* sender, const char* messageId, unsigned long now);
+
+    unsigned long getCheckCount () { return checkCount; }
+    unsigned long getHitCount () { return hitCount; }
+    uint8_t getHitRatePercent () { return checkCount == 0 ? 0 : (uint8_t)((hitCount * 100) / checkCount); }
+
+  protected:
+    struct RecentMessage {
+      uint32_t fingerprint; // 0 = empty
+      unsigned long seenAt;
+    };
+
+    RecentMessage slots[RECENT_MESSAGE_SLOTS];
+    unsigned long checkCount = 0;
+    unsigned long hitCount = 0;
+
+    uint32_t fingerprint (const char* sender, const char* messageId);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "StorageSession.h"
+
+StorageSession::StorageSession (uint8_t _csPin, SPIClass* _spi) {
+  csPin = _csPin;
+  spi = _spi;
+}
+
+bool StorageSession::open () {
+  unsigned long openStart = micros();
+  unsigned long now = millis();
+
+  if (state == StorageBackoff) {
+    if ((long)(now - retryAt) < 0) {
+      return false;
+    }
+    state = StorageUnmounted;
+  }
+
+  if (state == StorageUnmounted) {
+    if (!mount()) {
+      fail(now);
+      return false;
+    }
+  }
+  else if ((unsigned long)(now - lastProbe) >= STORAGE_PROBE_INTERVAL) {
+    // the mount can outlive the card, check it's still answering
+    if (!probe()) {
+      Logger::warn("Storage stopped responding, remounting", LogStorage);
+      errors++;
+      unmount();
+      if (!mount()) {
+        fail(now);
+        return false;
+      }
+    }
+  }
+
+  opens++;
+  openMicros += micros() - openStart;
+  return true;
+}
+
+bool StorageSession::mount () {
+  Logger::info("Opening storage", LogStorage);
+  unsigned long mountStart = micros();
+  if (!SD.begin(csPin, *spi)) {
+    Logger::error("Open storage failed!", LogStorage);
+    return false;
+  }
+  if (SD.cardType() == CARD_NONE) {
+    Logger::warn("No SD card attached", LogStorage);
+    SD.end();
+    return false;
+  }
+
+  mounts++;
+  mountMicros += micros() - mountStart;
+  state = StorageMounted;
+  backoff = STORAGE_REMOUNT_MIN_BACKOFF;
+  lastProbe = millis();
+  Logger::info("Storage is open", LogStorage);
+  return true;
+}
+
+bool StorageSession::probe () {
+  lastProbe = millis();
+  return SD.exists(STORAGE_PROBE_PATH);
+}
+
+void StorageSession::fail (unsigned long now) {
+  errors++;
+  state = StorageBackoff;
+  retryAt = now + backoff;
+  backoff = backoff * 2 < STORAGE_REMOUNT_MAX_BACKOFF ? backoff * 2 : STORAGE_REMOUNT_MAX_BACKOFF;
+}
+
+void StorageSession::reportError () {
+  if (state != StorageMounted) {
+    return;
+  }
+
+  // one failed write isn't much to go on, probe before tearing down the mount
+  if (!probe()) {
+    unmount();
+    fail(millis());
+  }
+  else {
+    errors++;
+  }
+}
+
+void StorageSession::unmount () {
+  if (state == StorageMounted) {
+    SD.end();
+    Logger::info("Storage is closed", LogStorage);
+  }
+  state = StorageUnmounted;
+}
+
+int StorageSession::writeSummary (char* buffer, int maxLength) {
+  const char* stateName = state == StorageMounted ? "mounted" : (state == StorageBackoff ? "backoff" : "unmounted");
+  int pos = snprintf(buffer, maxLength, "SD %s, mounts %lu (%lu ms), opens %lu (%lu us), errors %lu (%d%%)",
+    stateName, mounts, getAverageMountMillis(), opens, getAverageOpenMicros(), errors, getErrorRatePercent());
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include <SD.h>
+#include <SPI.h>
+#include "ChatterAll.h"
+
+#ifndef STORAGESESSION_H
+#define STORAGESESSION_H
+
+#define STORAGE_REMOUNT_MIN_BACKOFF 1000 // first retry after a failed mount
+#define STORAGE_REMOUNT_MAX_BACKOFF 60000 // doubling stops here
+#define STORAGE_PROBE_INTERVAL 30000 // a mounted card is checked at most this often
+#define STORAGE_PROBE_PATH "/"
+
+enum StorageMountState {
+  StorageUnmounted = 0,
+  StorageMounted = 1,
+  StorageBackoff = 2 // mount or probe failed, waiting to try again
+};
+
+/**
+ * Keeps the SD card mounted across sessions instead of mounting per call.
+ * A session is open() .. close(). Opening a mounted card costs nothing but
+ * an occasional probe. A failed mount or probe unmounts and retries later,
+ * doubling the wait each time, so a missing card doesn't cost an SPI init
+ * every cycle.
+ */
+class StorageSession {
+  public:
+    StorageSession (uint8_t _csPin, SPIClass* _spi);
+
+    // cheap, no card access
+    bool ready () { return state == StorageMounted; }
+    StorageMountState getState () { return state; }
+
+    bool open (); // mounts if needed and not backing off, true if the card can be used
+    void close () {} // the mount outlives the session
+    // a caller's write failed (a zone still dirty after its flush, a delete that didn't
+    // happen). the card is probed, and remounted after a backoff if it doesn't answer
+    void reportError ();
+    void unmount ();
+
+    unsigned long getMountCount () { return mounts; }
+    unsigned long getAverageMountMillis () { return mounts == 0 ? 0 : mountMicros / mounts / 1000ul; }
+    unsigned long getOpenCount () { return opens; }
+    unsigned long getAverageOpenMicros () { return opens == 0 ? 0 : openMicros / opens; }
+    unsigned long getErrorCount () { return errors; }
+    uint8_t getErrorRatePercent () { return opens == 0 ? 0 : (uint8_t)((errors * 100ul) / (opens + errors)); }
+
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    uint8_t csPin;
+    SPIClass* spi;
+
+    StorageMountState state = StorageUnmounted;
+    unsigned long retryAt = 0;
+    unsigned long backoff = STORAGE_REMOUNT_MIN_BACKOFF;
+    unsigned long lastProbe = 0;
+
+    unsigned long mounts = 0;
+    unsigned long long mountMicros = 0;
+    unsigned long opens = 0;
+    unsigned long long openMicros = 0;
+    unsigned long errors = 0;
+
+    bool mount ();
+    bool probe ();
+    void fail (unsigned long now);
+};
+
+#endif
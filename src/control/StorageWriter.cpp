@@ -0,0 +1,59 @@
+#include "StorageWriter.h"
+
+bool StorageWriter::request (uint8_t zone) {
+  if (isPending(zone)) {
+    return false;
+  }
+
+  StorageWriteRequest* entry = requests.claim();
+  if (entry == nullptr) {
+    return false;
+  }
+  entry->zone = zone;
+  entry->queuedAt = millis();
+  requests.publish();
+
+  pendingMask |= (1 << zone);
+  return true;
+}
+
+bool StorageWriter::nextResult (StorageWriteResult& result) {
+  if (!results.pop(result)) {
+    return false;
+  }
+
+  pendingMask &= ~(1 << result.zone);
+  if (result.written) {
+    writeCount++;
+    totalWriteMicros += result.writeMicros;
+    if (result.writeMicros > maxWriteMicros) {
+      maxWriteMicros = result.writeMicros;
+    }
+  }
+  return true;
+}
+
+bool StorageWriter::completeRequest (bool written, unsigned long writeMicros) {
+  StorageWriteRequest* entry = requests.front();
+  StorageWriteResult* result = results.claim();
+  if (entry == nullptr || result == nullptr) {
+    // radio hasn't picked up earlier results, the request stays put
+    return false;
+  }
+
+  result->zone = entry->zone;
+  result->written = written;
+  result->queuedMillis = millis() - entry->queuedAt;
+  result->writeMicros = writeMicros;
+  results.publish();
+  requests.release();
+  return true;
+}
+
+void StorageWriter::recordStall (unsigned long stallMicros) {
+  stallCount++;
+  totalStallMicros += stallMicros;
+  if (stallMicros > maxStallMicros) {
+    maxStallMicros = stallMicros;
+  }
+}
@@ -0,0 +1,78 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "ChatterAll.h"
+#include "../tasks/SpscRing.h"
+
+#ifndef STORAGEWRITER_H
+#define STORAGEWRITER_H
+
+#define STORAGE_JOURNAL_SIZE 8 // flushes in flight, power of two. a zone is only journaled once, so one per zone is enough
+
+struct StorageWriteRequest {
+  uint8_t zone;
+  unsigned long queuedAt;
+};
+
+struct StorageWriteResult {
+  uint8_t zone;
+  bool written; // false if storage couldn't be opened, the zone should be tried again later
+  unsigned long queuedMillis; // how long the request sat in the journal
+  unsigned long writeMicros;
+};
+
+/**
+ * Journal between the radio task, which decides which zones are due, and the
+ * housekeeping task, which writes them to SD. Requests and results each go
+ * through their own SpscRing, so handing a zone over never waits on the
+ * writer. The journal only carries zone ids though, chatter has no way to
+ * hand out a zone's data: the write itself reads the live store under the
+ * chatter lock, so the radio still waits out one zone write at a time.
+ * Everything except nextRequest/completeRequest belongs to the radio side,
+ * including the stats.
+ */
+class StorageWriter {
+  public:
+    /** radio side **/
+    bool request (uint8_t zone); // false if already journaled or the journal is full
+    bool isPending (uint8_t zone) { return (pendingMask & (1 << zone)) != 0; }
+    bool hasPending () { return pendingMask != 0; } // journaled zones the radio hasn't seen written yet
+    bool nextResult (StorageWriteResult& result);
+
+    // time the control cycle couldn't run because storage was being written
+    void recordStall (unsigned long stallMicros);
+
+    /** housekeeping side **/
+    StorageWriteRequest* nextRequest () { return requests.front(); }
+    bool canComplete () { return results.getCount() < STORAGE_JOURNAL_SIZE; }
+    bool completeRequest (bool written, unsigned long writeMicros);
+    void setWriting (bool _writing) { if (_writing) { writesStarted++; } writing = _writing; }
+
+    // either side, lets the radio tell whether a wait overlapped a write
+    bool isWriting () { return writing; }
+    unsigned long getWritesStarted () { return writesStarted; }
+
+    /** stats **/
+    unsigned long getWriteCount () { return writeCount; }
+    unsigned long getMaxWriteMicros () { return maxWriteMicros; }
+    unsigned long getAvgWriteMicros () { return writeCount == 0 ? 0 : totalWriteMicros / writeCount; }
+    unsigned long getStallCount () { return stallCount; }
+    unsigned long getMaxStallMicros () { return maxStallMicros; }
+    unsigned long getTotalStallMillis () { return totalStallMicros / 1000; }
+
+  protected:
+    SpscRing<StorageWriteRequest, STORAGE_JOURNAL_SIZE> requests;
+    SpscRing<StorageWriteResult, STORAGE_JOURNAL_SIZE> results;
+    uint16_t pendingMask = 0;
+    volatile bool writing = false;
+    volatile unsigned long writesStarted = 0;
+
+    unsigned long writeCount = 0;
+    unsigned long totalWriteMicros = 0;
+    unsigned long maxWriteMicros = 0;
+
+    unsigned long stallCount = 0;
+    unsigned long long totalStallMicros = 0;
+    unsigned long maxStallMicros = 0;
+};
+
+#endif
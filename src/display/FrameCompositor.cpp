@@ -0,0 +1,74 @@
+#include "FrameCompositor.h"
+
+FrameCompositor::FrameCompositor (FrameSink* _sink) {
+  sink = _sink;
+  memset(shown, 0, sizeof(shown));
+}
+
+bool FrameCompositor::isFrameDue (unsigned long now) {
+  return !flushed || (unsigned long)(now - lastFlush) >= FRAME_MIN_INTERVAL;
+}
+
+unsigned long FrameCompositor::getMillisUntilDue (unsigned long now) {
+  if (isFrameDue(now)) {
+    return 0;
+  }
+  return FRAME_MIN_INTERVAL - (unsigned long)(now - lastFlush);
+}
+
+void FrameCompositor::invalidate () {
+  shownValid = false;
+}
+
+uint8_t FrameCompositor::flush (const uint8_t* frame, unsigned long now) {
+  uint8_t pagesThisFrame = 0;
+  uint16_t bytesThisFrame = 0;
+
+  for (uint8_t page = 0; page < FRAME_PAGES; page++) {
+    const uint8_t* framePage = &frame[page * FRAME_WIDTH];
+    uint8_t* shownPage = &shown[page * FRAME_WIDTH];
+
+    // narrow to the changed span of the page
+    int16_t first = 0;
+    int16_t last = FRAME_WIDTH - 1;
+    if (shownValid) {
+      while (first < FRAME_WIDTH && framePage[first] == shownPage[first]) {
+        first++;
+      }
+      if (first == FRAME_WIDTH) {
+        continue;
+      }
+      while (last > first && framePage[last] == shownPage[last]) {
+        last--;
+      }
+    }
+
+    uint8_t length = last - first + 1;
+    bytesThisFrame += sink->writePage(page, first, &framePage[first], length);
+    memcpy(&shownPage[first], &framePage[first], length);
+    pagesThisFrame++;
+  }
+
+  shownValid = true;
+  flushed = true;
+  lastFlush = now;
+
+  frames++;
+  pagesWritten += pagesThisFrame;
+  busBytes += bytesThisFrame;
+  lastFrameBytes = bytesThisFrame;
+  return pagesThisFrame;
+}
+
+void FrameCompositor::recordRender (unsigned long elapsedMicros) {
+  renderMicros += elapsedMicros;
+  if (elapsedMicros > worstRenderMicros) {
+    worstRenderMicros = elapsedMicros;
+  }
+}
+
+int FrameCompositor::writeSummary (char* buffer, int maxLength) {
+  int pos = snprintf(buffer, maxLength, "Frames %lu (%lu held), %lu pages, %lu B/frame (last %d), render %lu/%lu us",
+    frames, deferredFrames, pagesWritten, getAverageFrameBytes(), lastFrameBytes, getAverageRenderMicros(), worstRenderMicros);
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef FRAMECOMPOSITOR_H
+#define FRAMECOMPOSITOR_H
+
+#define FRAME_WIDTH 128
+#define FRAME_HEIGHT 64
+#define FRAME_PAGES (FRAME_HEIGHT / 8) // sh1106 pages are 8 pixel rows, one byte per column
+#define FRAME_BUFFER_SIZE (FRAME_WIDTH * FRAME_PAGES)
+#define FRAME_MIN_INTERVAL 100 // ms between flushes, changes in between are held for the next frame
+
+/**
+ * Where finished pages go. The panel driver on the device, something that
+ * just records them on the host.
+ */
+class FrameSink {
+  public:
+    virtual ~FrameSink () {}
+
+    // writes a run of columns within one page, returns the bytes it put on the bus
+    virtual uint16_t writePage (uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) = 0;
+};
+
+/**
+ * Keeps a copy of what the panel is showing, and on flush sends only the
+ * changed column span of each changed page. Everything drawn between two
+ * flushes goes out together, at most once per FRAME_MIN_INTERVAL.
+ */
+class FrameCompositor {
+  public:
+    FrameCompositor (FrameSink* _sink);
+
+    bool isFrameDue (unsigned long now);
+    unsigned long getMillisUntilDue (unsigned long now);
+
+    // frame is page major (the drawing library's buffer), returns how many pages were written
+    uint8_t flush (const uint8_t* frame, unsigned long now);
+
+    // the panel no longer matches the copy (cleared, powered off), the next flush sends everything
+    void invalidate ();
+
+    void recordDeferred () { deferredFrames++; }
+    void recordRender (unsigned long renderMicros);
+
+    unsigned long getFrameCount () { return frames; }
+    unsigned long getDeferredCount () { return deferredFrames; }
+    unsigned long getPagesWritten () { return pagesWritten; }
+    unsigned long getBusBytes () { return busBytes; }
+    uint16_t getLastFrameBytes () { return lastFrameBytes; }
+    unsigned long getAverageFrameBytes () { return frames > 0 ? busBytes / frames : 0; }
+    unsigned long getAverageRenderMicros () { return frames > 0 ? renderMicros / frames : 0; }
+    unsigned long getWorstRenderMicros () { return worstRenderMicros; }
+
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    FrameSink* sink;
+    uint8_t shown[FRAME_BUFFER_SIZE];
+    bool shownValid = true; // the panel starts cleared
+    bool flushed = false;
+    unsigned long lastFlush = 0;
+
+    unsigned long frames = 0;
+    unsigned long deferredFrames = 0;
+    unsigned long pagesWritten = 0;
+    unsigned long busBytes = 0;
+    uint16_t lastFrameBytes = 0;
+    unsigned long renderMicros = 0;
+    unsigned long worstRenderMicros = 0;
+};
+
+/**
+ * Applies page writes to its own image of the panel, so a host run can
+ * check that what was sent adds up to the frame, and which pages were touched.
+ */
+class RecordingFrameSink : public FrameSink {
+  public:
+    RecordingFrameSink () { memset(panel, 0, sizeof(panel)); memset(pageWrites, 0, sizeof(pageWrites)); }
+
+    uint16_t writePage (uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) {
+      memcpy(&panel[page * FRAME_WIDTH + column], data, length);
+      pageWrites[page]++;
+      return length;
+    }
+
+    bool matches (const uint8_t* frame) { return memcmp(panel, frame, FRAME_BUFFER_SIZE) == 0; }
+    unsigned long getPageWrites (uint8_t page) { return pageWrites[page]; }
+
+  protected:
+    uint8_t panel[FRAME_BUFFER_SIZE];
+    unsigned long pageWrites[FRAME_PAGES];
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "LineLayoutCache.h"
+
+LineLayoutCache::LineLayoutCache () {
+  clear();
+}
+
+void LineLayoutCache::clear () {
+  for (uint8_t line = 0; line < LAYOUT_CACHE_LINES; line++) {
+    for (uint8_t way = 0; way < LAYOUT_CACHE_WAYS; way++) {
+      layouts[line][way].valid = false;
+    }
+  }
+}
+
+uint32_t LineLayoutCache::hashText (const char* text) {
+  return fnv1a(text);
+}
+
+LineLayout* LineLayoutCache::find (uint8_t line, const char* text) {
+  if (line >= LAYOUT_CACHE_LINES) {
+    return nullptr;
+  }
+
+  uint32_t hash = hashText(text);
+  for (uint8_t way = 0; way < LAYOUT_CACHE_WAYS; way++) {
+    LineLayout* layout = &layouts[line][way];
+    // the hash does the rejecting, the compare only guards against a collision
+    if (layout->valid && layout->hash == hash && strncmp(layout->text, text, LAYOUT_TEXT_MAX) == 0) {
+      layout->lastUsed = ++useCounter;
+      hits++;
+      return layout;
+    }
+  }
+
+  misses++;
+  return nullptr;
+}
+
+LineLayout* LineLayoutCache::store (uint8_t line, const char* text, int16_t x0, int16_t y0, uint16_t width, const uint8_t* frame) {
+  if (line >= LAYOUT_CACHE_LINES || strlen(text) >= LAYOUT_TEXT_MAX) {
+    return nullptr;
+  }
+
+  // an empty way, otherwise the least recently used
+  LineLayout* layout = &layouts[line][0];
+  for (uint8_t way = 0; way < LAYOUT_CACHE_WAYS && layout->valid; way++) {
+    LineLayout* candidate = &layouts[line][way];
+    if (!candidate->valid || candidate->lastUsed < layout->lastUsed) {
+      layout = candidate;
+    }
+  }
+
+  layout->valid = true;
+  layout->hash = hashText(text);
+  snprintf(layout->text, LAYOUT_TEXT_MAX, "%s", text);
+  layout->x0 = x0;
+  layout->y0 = y0;
+  layout->width = width;
+  layout->lastUsed = ++useCounter;
+  for (uint8_t x = LAYOUT_BAND_LEFT; x < LAYOUT_BAND_RIGHT; x++) {
+    layout->band[x] = readBandColumn(frame, x, y0);
+  }
+  return layout;
+}
+
+void LineLayoutCache::render (LineLayout* layout, uint8_t* frame) {
+  for (uint8_t x = LAYOUT_BAND_LEFT; x < LAYOUT_BAND_RIGHT; x++) {
+    writeBandColumn(frame, x, layout->y0, layout->band[x]);
+  }
+}
+
+// the band usually straddles three pages, so the column is handled as one 24 bit run
+uint16_t LineLayoutCache::readBandColumn (const uint8_t* frame, uint8_t x, int16_t y0) {
+  uint8_t page = y0 >> 3;
+  uint8_t shift = y0 & 7;
+  uint32_t run = 0;
+  for (uint8_t p = 0; p < 3 && page + p < FRAME_PAGES; p++) {
+    run |= (uint32_t)frame[(page + p) * FRAME_WIDTH + x] << (8 * p);
+  }
+  return (uint16_t)(run >> shift);
+}
+
+void LineLayoutCache::writeBandColumn (uint8_t* frame, uint8_t x, int16_t y0, uint16_t bits) {
+  uint8_t page = y0 >> 3;
+  uint8_t shift = y0 & 7;
+  uint32_t mask = (uint32_t)0xFFFF << shift;
+  uint32_t value = (uint32_t)bits << shift;
+  for (uint8_t p = 0; p < 3 && page + p < FRAME_PAGES; p++) {
+    uint8_t* cell = &frame[(page + p) * FRAME_WIDTH + x];
+    uint8_t pageMask = (uint8_t)(mask >> (8 * p));
+    *cell = (*cell & ~pageMask) | ((uint8_t)(value >> (8 * p)) & pageMask);
+  }
+}
@@ -0,0 +1,62 @@
+#include "FrameCompositor.h"
+#include "../globals/Globals.h"
+#include "../globals/Fnv1a.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LINELAYOUTCACHE_H
+#define LINELAYOUTCACHE_H
+
+#define LAYOUT_CACHE_LINES 3 // one set per display line
+#define LAYOUT_TEXT_MAX 64
+#define LAYOUT_BAND_HEIGHT 16 // rows a line owns
+#define LAYOUT_BAND_LEFT 2 // progress bar is left of this
+#define LAYOUT_BAND_RIGHT (FRAME_WIDTH - 1) // mesh cache bar column, not part of the band
+
+struct LineLayout {
+  bool valid;
+  uint32_t hash;
+  char text[LAYOUT_TEXT_MAX];
+  int16_t x0;
+  int16_t y0;
+  uint16_t width;
+  uint32_t lastUsed;
+  uint16_t band[FRAME_WIDTH]; // the rendered line, one bit per row of the band for each column
+};
+
+/**
+ * Remembers how recently shown strings were laid out and what they looked
+ * like once drawn, keyed by a hash of the text. A line going back to a
+ * string it showed before (the rotating title, the receive status) is
+ * copied back into the frame instead of being measured and drawn again.
+ */
+class LineLayoutCache {
+  public:
+    LineLayoutCache ();
+
+    LineLayout* find (uint8_t line, const char* text);
+
+    // remembers a line just drawn into the frame, replacing the least recently used string
+    LineLayout* store (uint8_t line, const char* text, int16_t x0, int16_t y0, uint16_t width, const uint8_t* frame);
+
+    // puts the remembered pixels back over the line's band
+    void render (LineLayout* layout, uint8_t* frame);
+
+    void clear ();
+
+    unsigned long getHitCount () { return hits; }
+    unsigned long getMissCount () { return misses; }
+
+    static uint32_t hashText (const char* text);
+
+  protected:
+    LineLayout layouts[LAYOUT_CACHE_LINES][LAYOUT_CACHE_WAYS];
+    uint32_t useCounter = 0;
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+
+    static uint16_t readBandColumn (const uint8_t* frame, uint8_t x, int16_t y0);
+    static void writeBandColumn (uint8_t* frame, uint8_t x, int16_t y0, uint16_t bits);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "Sh1106FrameSink.h"
+
+uint16_t Sh1106FrameSink::writePage (uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) {
+  uint8_t panelColumn = column + SH1106_COLUMN_OFFSET;
+
+  // address byte, control byte, then page and column
+  wire->beginTransmission(address);
+  wire->write(SH1106_CONTROL_COMMAND);
+  wire->write(SH1106_SET_PAGE | page);
+  wire->write(SH1106_SET_COLUMN_LOW | (panelColumn & 0x0F));
+  wire->write(SH1106_SET_COLUMN_HIGH | (panelColumn >> 4));
+  wire->endTransmission();
+  uint16_t busBytes = 5;
+
+  // the column address moves along on its own as data is written
+  for (uint8_t sent = 0; sent < length; sent += SH1106_DATA_CHUNK) {
+    uint8_t chunk = length - sent < SH1106_DATA_CHUNK ? length - sent : SH1106_DATA_CHUNK;
+    wire->beginTransmission(address);
+    wire->write(SH1106_CONTROL_DATA);
+    wire->write(&data[sent], chunk);
+    wire->endTransmission();
+    busBytes += 2 + chunk;
+  }
+
+  return busBytes;
+}
+
+void Sh1106FrameSink::setDisplayOn (bool on) {
+  wire->beginTransmission(address);
+  wire->write(SH1106_CONTROL_COMMAND);
+  wire->write(on ? SH1106_DISPLAY_ON : SH1106_DISPLAY_OFF);
+  wire->endTransmission();
+}
+
+void Sh1106FrameSink::setChargePump (bool on) {
+  wire->beginTransmission(address);
+  wire->write(SH1106_CONTROL_COMMAND);
+  wire->write(SH1106_SET_DCDC);
+  wire->write(on ? SH1106_DCDC_ON : SH1106_DCDC_OFF);
+  wire->endTransmission();
+}
@@ -0,0 +1,42 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "FrameCompositor.h"
+
+#ifndef SH1106FRAMESINK_H
+#define SH1106FRAMESINK_H
+
+#define SH1106_COLUMN_OFFSET 2 // the controller has 132 columns, the glass shows 2..129
+#define SH1106_DATA_CHUNK 30 // data bytes per i2c transmission, stays well inside the wire buffer
+
+#define SH1106_CONTROL_COMMAND 0x00
+#define SH1106_CONTROL_DATA 0x40
+#define SH1106_SET_PAGE 0xB0
+#define SH1106_SET_COLUMN_LOW 0x00
+#define SH1106_SET_COLUMN_HIGH 0x10
+#define SH1106_DISPLAY_OFF 0xAE
+#define SH1106_DISPLAY_ON 0xAF
+#define SH1106_SET_DCDC 0xAD // followed by one of the two below
+#define SH1106_DCDC_OFF 0x8A
+#define SH1106_DCDC_ON 0x8B
+#define SH1106_DCDC_SETTLE 100 // ms after the charge pump is on before the panel should be lit
+
+/**
+ * Writes pages straight to an SH1106 over i2c, addressing just the columns
+ * being sent rather than the whole page.
+ */
+class Sh1106FrameSink : public FrameSink {
+  public:
+    Sh1106FrameSink (TwoWire* _wire, uint8_t _address) { wire = _wire; address = _address; }
+
+    uint16_t writePage (uint8_t page, uint8_t column, const uint8_t* data, uint8_t length);
+
+    // dark panel, with the charge pump off as well it draws next to nothing. ram is kept
+    void setDisplayOn (bool on);
+    void setChargePump (bool on);
+
+  protected:
+    TwoWire* wire;
+    uint8_t address;
+};
+
+#endif
@@ -3,6 +3,10 @@
 
 #define REMOTE_COMMAND_REPORT_BATTERY "Report Battery"
 #define REMOTE_COMMAND_REPORT_UPTIME "Report Uptime"
+#define REMOTE_COMMAND_REPORT_LATENCY "Report Latency"
+#define REMOTE_COMMAND_REPORT_STALLS "Report Stalls"
+#define REMOTE_COMMAND_REPORT_STORAGE "Report Storage"
+#define REMOTE_COMMAND_REPORT_TIMERS "Report Timers"
 #define REMOTE_COMMAND_REPORT_NEIGHBORS "Report Neighbors"
 
 #define REMOTE_COMMAND_PREFIX "CFG"
@@ -17,6 +21,10 @@ enum RemoteCommandType {
     RemoteCommandDisableLearn = 'D',
     RemoteCommandMessagesClear = 'C',
     RemoteCommandUptime = 'U',
+    RemoteCommandLatency = 'H',
+    RemoteCommandStalls = 'S',
+    RemoteCommandStorage = 'F',
+    RemoteCommandTimers = 'W',
     RemoteCommandNeighbors = 'N',
     RemoteCommandTriggerRelay = 'R',
     RemoteCommandLocationEnable = 'L',
@@ -0,0 +1,22 @@
+#include <stdint.h>
+
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#define FNV1A_OFFSET_BASIS 2166136261ul
+#define FNV1A_PRIME 16777619ul
+
+// 32 bit FNV-1a, cheap enough to key small tables on strings
+inline uint32_t fnv1aByte (uint32_t hash, uint8_t byte) {
+  return (hash ^ byte) * FNV1A_PRIME;
+}
+
+// folds text in up to the terminator or maxLength chars, chain calls by passing the last hash back in
+inline uint32_t fnv1a (const char* text, uint16_t maxLength = 0xFFFF, uint32_t hash = FNV1A_OFFSET_BASIS) {
+  for (uint16_t i = 0; i < maxLength && text[i] != 0; i++) {
+    hash = fnv1aByte(hash, (uint8_t)text[i]);
+  }
+  return hash;
+}
+
+#endif
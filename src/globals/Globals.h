@@ -67,6 +67,30 @@
 #define BRIDGE_WIFI_ALIAS "Bridge_Wifi"
 #define BRIDGE_CLOUD_ALIAS "Bridge_Cloud"*/
 
+// radio runs on the loop task, storage/display/gps on a housekeeping task on the other core
+#define CONTROL_TASK_SPLIT_ENABLED true
+
+// when a cycle leaves nothing to do, idle until the next deadline or the radio interrupt.
+// light sleep stops both cores, so with the housekeeping task running it's only used between its
+// passes, when nothing is queued for it. otherwise the loop blocks for the window
+#define IDLE_SCHEDULER_ENABLED true
+#define IDLE_LIGHT_SLEEP_ENABLED true
+#define IDLE_STARTUP_MAX_WINDOW 10 // ms the loop sleeps at most between startup steps, so buttons still get read
+
+// strings remembered per display line, enough for the four receive statuses. each one keeps its rendered
+// band (256 B) and text (64 B), ~340 B a string, so 3 lines x 4 take ~4 KB of RAM
+#define LAYOUT_CACHE_WAYS 4
+
+// overdue storage zones are flushed together, no new zone is started once a flush has taken this long
+#define STORAGE_FLUSH_BUDGET_MILLIS 250
+
+// factory reset deletes every storage file before the restart (seconds with a full card).
+// true moves the tree aside instead and deletes it a few files at a time after the restart. that is
+// not an erase: only the files at the top of the tree (device store, keys, headers) are overwritten
+// before the move, and every message stays readable on the card under the trash folder until the
+// background delete reaches it. neither one overwrites the deleted data itself
+#define FACTORY_RESET_FAST false
+
 #define MAX_CHANNELS 2 // how many can be simultaneously monitored at once
 #define CHANNEL_DISPLAY_SIZE 32 // how many chars the channel name + config can occupy for display purposes
 
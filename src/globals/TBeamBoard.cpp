@@ -302,14 +302,16 @@ void disablePeripherals()
 }
 
 
-void loopPMU()
+uint8_t loopPMU()
 {
+    uint8_t events = PMU_EVENT_NONE;
 #ifdef HAS_PMU
     if (!PMU) {
-        return;
+        return events;
     }
-    if (!pmuInterrupt) {
-        return;
+    // the falling edge is missed if it happens in light sleep, but the irq line stays low
+    if (!pmuInterrupt && digitalRead(PMU_IRQ) == HIGH) {
+        return events;
     }
 
     pmuInterrupt = false;
@@ -318,18 +320,23 @@ void loopPMU()
 
     if (PMU->isVbusInsertIrq()) {
         Logger::info("isVbusInsert", LogAppControl);
+        events |= PMU_EVENT_POWER;
     }
     if (PMU->isVbusRemoveIrq()) {
         Logger::info("isVbusRemove", LogAppControl);
+        events |= PMU_EVENT_POWER;
     }
     if (PMU->isBatInsertIrq()) {
         Logger::info("isBatInsert", LogAppControl);
+        events |= PMU_EVENT_POWER;
     }
     if (PMU->isBatRemoveIrq()) {
         Logger::info("isBatRemove", LogAppControl);
+        events |= PMU_EVENT_POWER;
     }
     if (PMU->isPekeyShortPressIrq()) {
         Logger::info("isPekeyShortPress", LogAppControl);
+        events |= PMU_EVENT_SHORT_PRESS;
     }
     if (PMU->isPekeyLongPressIrq()) {
         Logger::info("isPekeyLongPress", LogAppControl);
@@ -343,6 +350,7 @@ void loopPMU()
     // Clear PMU Interrupt Status Register
     PMU->clearIrqStatus();
 #endif
+    return events;
 }
 
 
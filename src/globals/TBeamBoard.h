@@ -31,7 +31,11 @@ void disablePeripherals();
 bool beginPower();
 void flashLed();
 bool beginGPS();
-void loopPMU();
+uint8_t loopPMU(); // PMU_EVENT_ flags for the irqs that were pending
+
+#define PMU_EVENT_NONE 0x00
+#define PMU_EVENT_SHORT_PRESS 0x01 // power key tapped
+#define PMU_EVENT_POWER 0x02 // usb or battery connected/removed
 
 #ifdef HAS_PMU
 extern XPowersLibInterface *PMU;
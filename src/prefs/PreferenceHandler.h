@@ -46,7 +46,8 @@ enum StoredPreference {
     StoredPrefGnssGlonassEnabled = 12,
     StoredPrefGnssBeiDouEnabled = 13,
     StoredPrefExperimentalFeaturesEnabled = 14,
-    StoredPrefAnalysisEnabled = 15
+    StoredPrefAnalysisEnabled = 15,
+    StoredPrefPruneState = 16 // not a user preference, see STORAGE_PRUNE_RUNNING
 };
 
 class PreferenceHandler {
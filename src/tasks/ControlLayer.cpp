@@ -1,16 +1,21 @@
 #include "ControlLayer.h"
 
-ControlLayer::ControlLayer(CallbackRegistry* _callbackRegistry) {
+ControlLayer::ControlLayer(CallbackRegistry* _callbackRegistry, TimerWheel* _timers, StepRuntime* _runtime) {
     globalCallbackRegistry = _callbackRegistry;
+    timers = _timers;
+    runtime = _runtime;
     globalCallbackRegistry->addCallback(CallbackChatStatus, this);
 
     memset(&displayLines[0][0], 0, DISPLAY_LINE_WIDTH*DISPLAY_NUM_LINES);
-    display = new SH1106Wire(0x3c);
+    display = new SH1106Wire(DISPLAY_I2C_ADDRESS);
+    frameSink = new Sh1106FrameSink(&Wire, DISPLAY_I2C_ADDRESS);
+    frames = new FrameCompositor(frameSink);
     if (!display->init()) {
         Logger::error("Display not ready!", LogUi);
         displayRunning = false;
     }
     else {
+        // the one full frame, the compositor takes it from here
         display->cls();
         display->display();
         displayRunning = true;
@@ -28,6 +33,24 @@ void ControlLayer::setControlMode (ControlMode* _control) {
 }
 
 bool ControlLayer::process (ChatterUserEvent evt) {
+    {
+        // the housekeeping task schedules and consumes on the same wheel, under the same lock
+        TaskLockGuard guard(&chatterLock);
+
+        // the only place deadlines are checked against the clock
+        timers->advance(millis());
+
+        if (evt != UserEventNone) {
+            wakeDisplay(DisplayWakeButton);
+        }
+
+        // anything that would have waited in delay() picks up where it left off
+        runtime->runDue();
+    }
+
+    // status writes since the last frame, the housekeeping task does its own
+    refreshDisplay();
+
     if (!initialized) {
         // do nothing until initialized
         processControlModeNotReady(evt);
@@ -51,19 +74,59 @@ bool ControlLayer::process (ChatterUserEvent evt) {
     default:
         if (control != nullptr) {
             if (status == ControlModeReady || status == ControlModeProcessing) {
-                rotateDisplay();
+                // anything the last iteration (or the housekeeping task) tripped over
+                control->reportStalls();
+                StallMonitor* stalls = control->getLoopStalls();
+                StallIteration iteration(stalls);
 
-                // Only flush storage if screen is locked, so we dont tie up UI
-                bool storageFlushed = false;
-                if (isMessagingPaused() == false) {
-                    storageFlushed = control->flushStorage();
-                    if (storageFlushed) {
+                if (CONTROL_TASK_SPLIT_ENABLED && !housekeepingStartAttempted) {
+                    startHousekeeping();
+                }
+
+                if (housekeepingWaiting) {
+                    // let the other core have chatter for a moment
+                    TaskPlatform::sleepMillis(1);
+                }
+                StorageWriter* storageWriter = control->getStorageWriter();
+                bool writeOverlapped = storageWriter->isWriting();
+                unsigned long writesBefore = storageWriter->getWritesStarted();
+                unsigned long lockWaitMicros;
+                stalls->enter(StallPhaseLockWait);
+                TaskLockGuard guard(&chatterLock, &lockWaitMicros);
+                stalls->exit(StallPhaseLockWait);
+                if (lockWaitMicros > 0 && (writeOverlapped || storageWriter->getWritesStarted() != writesBefore)) {
+                    // the radio sat waiting on an SD write
+                    control->getStorageWriter()->recordStall(lockWaitMicros);
+                }
+
+                if (timers->consume(TimerMessagingPause)) {
+                    Logger::debug("Messaging pause is over", LogAppControl);
+                }
+
+                if (housekeepingRunning) {
+                    // storage, gps and display belong to the housekeeping task now
+                    if (isMessagingPaused() == false) {
+                        control->processOneCycle(ControlCycleRadio);
+                    }
+                    break;
+                }
+
+                stalls->enter(StallPhaseDisplay);
+                rotateDisplay();
+                stalls->exit(StallPhaseDisplay);
+
+                // without the housekeeping task the flush is inline, and the whole write is a stall
+                if (isMessagingPaused() == false && timers->isDue(TimerStorageFlush)) {
+                    stalls->enter(StallPhaseFlush);
+                    unsigned long flushStart = micros();
+                    if (control->flushStorage()) {
+                        control->getStorageWriter()->recordStall(micros() - flushStart);
                         Logger::debug("SD was written", LogAppControl);
                     }
+                    stalls->exit(StallPhaseFlush);
                 }
 
-                // dont take up any processing time if a flush was just done
-                if (isMessagingPaused() == false && storageFlushed == false) {
+                if (isMessagingPaused() == false) {
                     control->processOneCycle(ControlCycleFull);
                 }
             }
@@ -81,10 +144,89 @@ bool ControlLayer::process (ChatterUserEvent evt) {
         status = ControlModeReady;
     }
 
+    if (housekeepingRunning) {
+        // whatever the cycle left on each line, however many times it was written
+        postPendingDisplayLines();
+    }
+
   return true;
 }
 
 
+bool ControlLayer::startHousekeeping () {
+    housekeepingStartAttempted = true;
+
+    // set first, so display updates from here on are queued for the new task
+    housekeepingRunning = true;
+    if (TaskPlatform::startTask("housekeeping", housekeepingTask, this, TASK_HOUSEKEEPING_STACK, TASK_HOUSEKEEPING_PRIORITY, TASK_HOUSEKEEPING_CORE)) {
+        Logger::info("Housekeeping task started", LogAppControl);
+    }
+    else {
+        // everything stays on the loop task
+        housekeepingRunning = false;
+        Logger::error("Housekeeping task failed to start", LogAppControl);
+    }
+    return housekeepingRunning;
+}
+
+void ControlLayer::housekeepingTask (void* arg) {
+    ControlLayer* layer = (ControlLayer*)arg;
+    layer->housekeepingTaskId = TaskPlatform::currentTaskId();
+    while (true) {
+        layer->processHousekeeping();
+        TaskPlatform::sleepMillis(HOUSEKEEPING_INTERVAL);
+    }
+}
+
+void ControlLayer::processHousekeeping () {
+    StallMonitor* stalls = control->getHousekeepingStalls();
+    StallIteration iteration(stalls);
+
+    // light sleep stops this core too, so the loop doesn't sleep while a pass is running
+    TaskLockGuard passGuard(&housekeepingPassLock);
+
+    housekeepingWaiting = true;
+    stalls->enter(StallPhaseLockWait);
+    bool locked = chatterLock.tryLock(HOUSEKEEPING_LOCK_WAIT);
+    stalls->exit(StallPhaseLockWait);
+    housekeepingWaiting = false;
+
+    if (locked) {
+        stalls->enter(StallPhaseDisplay);
+        rotateDisplay();
+        stalls->exit(StallPhaseDisplay);
+        if (isMessagingPaused() == false && control->processHousekeeping()) {
+            Logger::debug("SD was pruned", LogAppControl);
+        }
+        chatterLock.unlock();
+
+        // one journaled zone per lock hold, so the radio gets chatter back between zones
+        while (control->getStorageWriter()->nextRequest() != nullptr && chatterLock.tryLock(HOUSEKEEPING_LOCK_WAIT)) {
+            bool written = control->writeStorageJournal();
+            chatterLock.unlock();
+            if (!written) {
+                break;
+            }
+        }
+    }
+
+    // drawing doesn't need chatter, so the radio can carry on while the oled is written
+    applyScreenPower();
+    bool changed = displayDirty.exchange(false);
+    DisplayUpdate* update;
+    while ((update = displayUpdates.front()) != nullptr) {
+        sprintf(&displayLines[update->line][0], "%s", update->text);
+        displayUpdates.release();
+        changed = true;
+    }
+
+    if (changed) {
+        stalls->enter(StallPhaseDisplay);
+        updateDisplay(displayLines);
+        stalls->exit(StallPhaseDisplay);
+    }
+}
+
 void ControlLayer::processControlModeNotReady (ChatterUserEvent evt) {
     if (status == ControlStartupUnlicensed) {
         Logger::warn("Device is unlicensed!", LogAppControl);
@@ -122,10 +264,8 @@ void ControlLayer::processControlModeNotReady (ChatterUserEvent evt) {
 void ControlLayer::pauseMessagingFor(unsigned long pauseLengthMillis) { 
     // if messaging is already paused for a certain amount of time,
     // we dont' want to reduce the pause
-    unsigned long thisPause = millis() + pauseLengthMillis;
-    if (thisPause > messagingPausedUntil) {
-        messagingPausedUntil = thisPause;
-    }
+    TaskLockGuard guard(&chatterLock);
+    timers->extend(TimerMessagingPause, pauseLengthMillis);
 }
 
 void ControlLayer::configureDeviceSettings() {
@@ -145,11 +285,138 @@ void ControlLayer::configureDeviceSettings() {
             break;
     }
     control->getChatter()->getRtc()->setGpsUpdateFrequency(60000); // only every 60 sec. should become setting
+
+    if (screenTimeout > 0) {
+        TaskLockGuard guard(&chatterLock);
+        timers->schedule(TimerScreenTimeout, screenTimeout);
+    }
+}
+
+void ControlLayer::wakeDisplay (DisplayWakeEvent event) {
+    if ((displayWakeEvents & event) == 0) {
+        return;
+    }
+
+    TaskLockGuard guard(&chatterLock);
+    lastUserInteraction = millis();
+    if (screenTimeout > 0) {
+        timers->schedule(TimerScreenTimeout, screenTimeout);
+    }
+    if (screenState != ScreenOn) {
+        screenWakeRequested = true;
+
+        // the title is stale, rotate now
+        timers->cancel(TimerTitleRotation);
+    }
+}
+
+void ControlLayer::applyScreenPower () {
+    if (!displayRunning) {
+        return;
+    }
+
+    if (screenWakeRequested.exchange(false) && screenState == ScreenOff) {
+        // a wake beats a sleep that hasn't happened yet
+        screenSleepRequested = false;
+        frameSink->setChargePump(true);
+        screenWakeAt = millis() + SH1106_DCDC_SETTLE;
+        screenState = ScreenWaking;
+    }
+    else if (screenState == ScreenWaking && TimerWheel::deadlineReached(millis(), screenWakeAt)) {
+        frameSink->setDisplayOn(true);
+        screenState = ScreenOn;
+
+        // everything is redrawn and pushed, the panel ram isn't trusted after power down
+        memset(&lastDisplayLines[0][0], 0, DISPLAY_LINE_WIDTH*DISPLAY_NUM_LINES);
+        frames->invalidate();
+        displayDirty = true;
+        Logger::info("Screen on", LogUi);
+    }
+    else if (screenSleepRequested.exchange(false) && screenState == ScreenOn) {
+        frameSink->setDisplayOn(false);
+        frameSink->setChargePump(false);
+        screenState = ScreenOff;
+
+        char frameSummary[128];
+        frames->writeSummary(frameSummary, 128);
+        Logger::info("Screen off. ", frameSummary, LogUi);
+    }
+}
+
+void ControlLayer::idle () {
+    if (!initialized) {
+        // only startup steps are running, wait for the next one instead of spinning
+        unsigned long stepWindow = runtime->getMillisUntilNext();
+        TaskPlatform::sleepMillis(stepWindow < IDLE_STARTUP_MAX_WINDOW ? stepWindow : IDLE_STARTUP_MAX_WINDOW);
+        return;
+    }
+
+    if (!IDLE_SCHEDULER_ENABLED || control == nullptr || status != ControlModeReady || onboarding) {
+        return;
+    }
+
+    // the wheel is read under the lock, the wait itself isn't
+    unsigned long now;
+    unsigned long window;
+    {
+        TaskLockGuard guard(&chatterLock);
+        if (timers->hasDue() || control->hasPendingWork()) {
+            return;
+        }
+
+        // flushes, gps, title rotation, outbound schedules and step tasks are all deadlines
+        now = millis();
+        window = timers->getMillisUntilNext(now);
+    }
+    unsigned long stepWindow = runtime->getMillisUntilNext();
+    if (stepWindow < window) {
+        window = stepWindow;
+    }
+
+    // so is a status change waiting on the frame rate, unless the housekeeping task draws it
+    if (screenState == ScreenWaking && !housekeepingRunning) {
+        unsigned long untilOn = TimerWheel::deadlineReached(now, screenWakeAt) ? 0 : screenWakeAt - now;
+        if (untilOn < window) {
+            window = untilOn;
+        }
+    }
+    else if (displayDirty && screenState == ScreenOn && !housekeepingRunning) {
+        unsigned long frameWindow = frames->getMillisUntilDue(now);
+        if (frameWindow < window) {
+            window = frameWindow;
+        }
+    }
+
+    if (!housekeepingRunning) {
+        control->getIdleScheduler()->setLightSleepAllowed(IDLE_LIGHT_SLEEP_ENABLED);
+        control->sleepOrBackground(window);
+        return;
+    }
+
+    // the housekeeping task can't start a pass while the pass lock is held, so it's safe to stop both cores
+    bool sleepAllowed = IDLE_LIGHT_SLEEP_ENABLED && housekeepingPassLock.tryLock();
+    if (sleepAllowed && !canSleepWithHousekeeping()) {
+        housekeepingPassLock.unlock();
+        sleepAllowed = false;
+    }
+    control->getIdleScheduler()->setLightSleepAllowed(sleepAllowed);
+    control->sleepOrBackground(window);
+    if (sleepAllowed) {
+        housekeepingPassLock.unlock();
+    }
+}
+
+bool ControlLayer::canSleepWithHousekeeping () {
+    // anything queued for the housekeeping task would wait out the whole window
+    return !control->getStorageWriter()->hasPending() && displayUpdates.isEmpty() && pendingDisplayMask == 0 && !displayDirty;
 }
 
 bool ControlLayer::joinCluster () {
     updateChatViewStatus("Please Onboard Me!");
+    TaskLockGuard guard(&chatterLock);
     control->joinCluster();
+    onboarding = true;
+    return true;
 }
 
 ControlModeStatus ControlLayer::initializeNextStep () {
@@ -244,12 +511,15 @@ ControlModeStatus ControlLayer::initializeNextStep () {
 }
 
 void ControlLayer::messageReceived () {
+    wakeDisplay(DisplayWakeMessage);
     updateDisplay("Message Received", DISPLAY_STATUS_ROW);
 }
 
 void ControlLayer::updateCacheUsed(float pct) {
-    meshCachePct = pct;
-    updateDisplay();
+    if (pct != meshCachePct) {
+        meshCachePct = pct;
+        updateDisplay();
+    }
 }
 
 void ControlLayer::updateChatViewStatus (const char* status) {
@@ -257,8 +527,11 @@ void ControlLayer::updateChatViewStatus (const char* status) {
 }
 
 void ControlLayer::updateChatViewProgress (float progress) {
-    generalProgress = progress;
-    updateDisplay();
+    // reset to 0 every cycle, most calls change nothing
+    if (progress != generalProgress) {
+        generalProgress = progress;
+        updateDisplay();
+    }
 }
 
 void ControlLayer::updateChatViewStatus (uint8_t channelNum, ChatViewStatus newStatus) {
@@ -266,22 +539,23 @@ void ControlLayer::updateChatViewStatus (uint8_t channelNum, ChatViewStatus newS
 }
 
 void ControlLayer::updateDashboard () {
-    uint8_t dashPos = 0;
+    // built aside and posted like any other line, this is called from the radio side
+    char dashboard[DISPLAY_LINE_WIDTH];
+    int dashPos = 0;
     Chatter* chatter = control->getChatter();
-    for (uint8_t c = 0; c < chatter->getNumChannels(); c++) {
+    for (uint8_t c = 0; c < chatter->getNumChannels() && dashPos < DISPLAY_LINE_WIDTH - 1; c++) {
         if (c > 0) {
-            displayLines[DISPLAY_DASHBOARD_ROW][dashPos++] = ',';
-            displayLines[DISPLAY_DASHBOARD_ROW][dashPos++] = ' ';
-            displayLines[DISPLAY_DASHBOARD_ROW][dashPos++] = ' ';
+            dashPos += snprintf(&dashboard[dashPos], DISPLAY_LINE_WIDTH - dashPos, ",  ");
         }
         ChatterChannel* chan = chatter->getChannel(c);
         sprintf(displayRowBuffer, "%s@%s %s", chan->getName(), chan->getConfigName(), getStatusName(chatter->getChatStatus(c)));
-        sprintf(&displayLines[DISPLAY_DASHBOARD_ROW][dashPos], "%s", displayRowBuffer);
-        dashPos += strlen(displayRowBuffer);
+        if (dashPos < DISPLAY_LINE_WIDTH - 1) {
+            dashPos += snprintf(&dashboard[dashPos], DISPLAY_LINE_WIDTH - dashPos, "%s", displayRowBuffer);
+        }
     }
+    dashboard[dashPos < DISPLAY_LINE_WIDTH ? dashPos : DISPLAY_LINE_WIDTH - 1] = 0;
 
-    // update the full display
-    updateDisplay();
+    updateDisplay(dashboard, DISPLAY_DASHBOARD_ROW);
 }
 
 void ControlLayer::subChannelHopped () {
@@ -299,7 +573,17 @@ void ControlLayer::yieldForProcessing () {
 }
 
 void ControlLayer::rotateDisplay () {
-    if (millis() - titleLastRotation > TITLE_ROTATION_FREQUENCY) {
+    if (timers->consume(TimerScreenTimeout)) {
+        Logger::info("Screen timeout", LogUi);
+        screenSleepRequested = true;
+    }
+
+    if (screenState != ScreenOn) {
+        // the title costs a battery read and a ping table scan, no point while dark
+        return;
+    }
+
+    if (timers->isIdle(TimerTitleRotation) || timers->consume(TimerTitleRotation)) {
         switch (currTitleItem) {
             case TitleAlias:
                 currTitleItem = TitleTime;
@@ -312,7 +596,7 @@ void ControlLayer::rotateDisplay () {
                 if(control->getGpsCoords(lat, lng)) {
                     sprintf(titleLine, "%.6f, %.6f", lat, lng);
                 }
-                else if (control->getChatter()->getRtc()->getGnssEnabled() == false) {
+                else if (control->getLocationSampler()->getLatest().gnssEnabled == false) {
                     sprintf(titleLine, "%s", "Location: [disabled]");
                 }
                 else {
@@ -331,16 +615,46 @@ void ControlLayer::rotateDisplay () {
                 break;
         }
         updateTitle(titleLine);
-        titleLastRotation = millis();
+        timers->schedule(TimerTitleRotation, TITLE_ROTATION_FREQUENCY);
     }
 }
 
 void ControlLayer::updateDisplay () {
+    if (housekeepingRunning || initialized) {
+        // just a state write, drawn on the next housekeeping pass or refreshDisplay
+        displayDirty = true;
+        return;
+    }
+
+    // startup steps can block for a while, so their status goes out right away
     updateDisplay(displayLines);
 }
 
+void ControlLayer::refreshDisplay () {
+    if (housekeepingRunning) {
+        return;
+    }
+
+    applyScreenPower();
+    if (displayDirty && frames->isFrameDue(millis())) {
+        displayDirty = false;
+        updateDisplay(displayLines);
+    }
+}
+
 void ControlLayer::updateDisplay (const char* dispText, uint8_t line) {
     if (line < DISPLAY_NUM_LINES && strlen(dispText) < DISPLAY_LINE_WIDTH) {
+        if (housekeepingRunning) {
+            // only the housekeeping task touches the lines once it's running, anyone else posts to it
+            if (TaskPlatform::currentTaskId() == housekeepingTaskId) {
+                sprintf(&displayLines[line][0], "%s", dispText);
+                displayDirty = true;
+            }
+            else {
+                postDisplayLine(dispText, line);
+            }
+            return;
+        }
         sprintf(&displayLines[line][0], "%s", dispText);
         updateDisplay();
     }
@@ -349,6 +663,27 @@ void ControlLayer::updateDisplay (const char* dispText, uint8_t line) {
     }
 }
 
+void ControlLayer::postDisplayLine (const char* dispText, uint8_t line) {
+    // a plain write, latest wins. process() posts it once the cycle is done
+    sprintf(&pendingDisplayLines[line][0], "%s", dispText);
+    pendingDisplayMask |= (1 << line);
+}
+
+void ControlLayer::postPendingDisplayLines () {
+    for (uint8_t line = 0; line < DISPLAY_NUM_LINES && pendingDisplayMask != 0; line++) {
+        if (pendingDisplayMask & (1 << line)) {
+            DisplayUpdate* update = displayUpdates.claim();
+            if (update == nullptr) {
+                return;
+            }
+            update->line = line;
+            sprintf(update->text, "%s", &pendingDisplayLines[line][0]);
+            displayUpdates.publish();
+            pendingDisplayMask &= ~(1 << line);
+        }
+    }
+}
+
 void ControlLayer::updateTitle (const char* title) {
     updateDisplay(title, DISPLAY_TITLE_ROW);
 }
@@ -358,78 +693,93 @@ void ControlLayer::updateSubtitle (const char* subtitle) {
 }
 
 void ControlLayer::updateNeighbors () {
-    if (lastNeighborsUpdate == 0 || millis() - lastNeighborsUpdate > 10000) {
+    if (timers->isIdle(TimerNeighborsUpdate) || timers->consume(TimerNeighborsUpdate)) {
         lastNumNeighbors = control->getChatter()->getPingTable()->getNumNearbyDevices (PingQualityBad, 90);
+        timers->schedule(TimerNeighborsUpdate, 10000);
     }
 }
 
 void ControlLayer::updateDisplay (const char lines[DISPLAY_NUM_LINES][DISPLAY_LINE_WIDTH]) {
     if (displayRunning) {
+        if (screenState != ScreenOn) {
+            // nothing goes to the panel while it's dark, waking redraws everything
+            return;
+        }
+
+        if (!frames->isFrameDue(millis())) {
+            // held until the next frame, whoever draws next picks it up
+            frames->recordDeferred();
+            displayDirty = true;
+            return;
+        }
+
+        unsigned long renderStart = micros();
         bool somethingChanged = false;
 
-        // clear any lines that were changed
+        // everything is drawn into the buffer first, the panel gets one flush at the end
         for (uint8_t line = 0; line < DISPLAY_NUM_LINES; line++) {
-            bool changed = false;
-            for (uint8_t charCount = 0; charCount < DISPLAY_LINE_WIDTH; charCount++) {
-                if (lines[line][charCount] != lastDisplayLines[line][charCount]) {
-                    lastDisplayLines[line][charCount] = lines[line][charCount];
-                    changed = true;
-                }
+            if (memcmp(lines[line], lastDisplayLines[line], DISPLAY_LINE_WIDTH) == 0) {
+                continue;
             }
-            if (changed) {
-                somethingChanged = true;
+            memcpy(lastDisplayLines[line], lines[line], DISPLAY_LINE_WIDTH);
+            somethingChanged = true;
 
-                display->setColor(BLACK);
-                display->fillRect(1, line * DISPLAY_LINE_HEIGHT + (.5 * DISPLAY_LINE_HEIGHT), display->width() - 2, DISPLAY_LINE_HEIGHT);
-                display->display();
+            // each line owns a band, between the progress bars, so only it needs redrawing
+            int y0 = DISPLAY_TEXT_TOP + line * DISPLAY_LINE_HEIGHT;
+            LineLayout* layout = layouts.find(line, lines[line]);
+            if (layout != nullptr) {
+                // shown before, no measuring or glyph drawing
+                layouts.render(layout, display->buffer);
+                continue;
             }
-        }
 
-        if (lastGeneralProgress != generalProgress) {
             display->setColor(BLACK);
-            display->fillRect(0,0,2,display->height());
-            display->display();
-            somethingChanged = true;
-            lastGeneralProgress = generalProgress;
+            display->fillRect(LAYOUT_BAND_LEFT, y0, LAYOUT_BAND_RIGHT - LAYOUT_BAND_LEFT, DISPLAY_LINE_HEIGHT);
+
+            // starting x position - screen width minus string width  / 2
+            uint16_t width = display->getStringWidth(lines[line], strlen(lines[line]));
+            int x0 = (display->width() - width) / 2;
+            display->setColor(WHITE);
+            display->drawString(x0, y0, lines[line]);
+            layouts.store(line, lines[line], x0, y0, width, display->buffer);
         }
 
-        if (lastMeshCachePct != meshCachePct) {
-            display->setColor(BLACK);
-            display->fillRect(display->width() - 1,0,2,display->height());
-            display->display();
+        // a long line can run over the bars, so they go back on top of any text change
+        float progress = generalProgress.load();
+        if (somethingChanged || lastGeneralProgress != progress) {
+            lastGeneralProgress = progress;
             somethingChanged = true;
-            lastMeshCachePct = meshCachePct;
-        }
-
 
-        if (somethingChanged) {
-            display->setColor(WHITE); //?
-
-            // draw general progress line on the right
-            uint8_t lineHeight = generalProgress * display->height();
+            // draw general progress line on the left
+            uint8_t lineHeight = progress * display->height();
+            display->setColor(BLACK);
+            display->fillRect(0, 0, 2, display->height());
+            display->setColor(WHITE);
             display->drawLine(
                 1, display->height() - lineHeight,
-                1, display->width()
+                1, display->height()
             );
+        }
 
-            for (uint8_t l = 0; l < DISPLAY_NUM_LINES; l++) {
-                // starting x position - screen width minus string width  / 2
-                int x0 = (display->width() - display->getStringWidth(lines[l], strlen(lines[l]))) / 2;
-
-                // starting y position - screen height minus string height / 2
-                int y0 = (((display->height() - DISPLAY_LINE_HEIGHT)) / 2) + (((l - 1) * (DISPLAY_LINE_HEIGHT) + 4));
-
-                // Draw the text - color of black (0)
-                display->drawString(x0, y0, lines[l]);
-            }
+        float cachePct = meshCachePct.load();
+        if (somethingChanged || lastMeshCachePct != cachePct) {
+            lastMeshCachePct = cachePct;
+            somethingChanged = true;
 
             // draw mesh cache line on the right
-            lineHeight = meshCachePct * display->getHeight();
+            uint8_t lineHeight = cachePct * display->height();
+            display->setColor(BLACK);
+            display->fillRect(display->width() - 1, 0, 1, display->height());
+            display->setColor(WHITE);
             display->drawLine(
                 display->width() - 1, display->height() - lineHeight,
                 display->width() - 1, display->height()
             );
-            display->display();
+        }
+
+        if (somethingChanged) {
+            frames->flush(display->buffer, millis());
+            frames->recordRender(micros() - renderStart);
         }
     }
 }
@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <atomic>
 #include "../control/ControlMode.h"
 #include "../control/HeadlessControlMode.h"
 #include "../events/ChatterUserEvent.h"
@@ -6,6 +7,13 @@
 #include "../callbacks/ChatterViewCallback.h"
 #include "../forms/DeviceInitializationForm.h"
 #include "../forms/NewClusterForm.h"
+#include "TimerWheel.h"
+#include "StepRuntime.h"
+#include "TaskPlatform.h"
+#include "SpscRing.h"
+#include "../display/FrameCompositor.h"
+#include "../display/Sh1106FrameSink.h"
+#include "../display/LineLayoutCache.h"
 #include <SH1106Wire.h>
 
 #ifndef CONTROLLAYER_H
@@ -15,6 +23,8 @@
 #define DISPLAY_NUM_LINES 3
 
 #define DISPLAY_LINE_HEIGHT 16
+#define DISPLAY_TEXT_TOP 12 // first text row, each line gets a DISPLAY_LINE_HEIGHT band from here
+#define DISPLAY_I2C_ADDRESS 0x3c
 
 #define DISPLAY_TITLE_ROW 0
 #define DISPLAY_DASHBOARD_ROW 1
@@ -22,6 +32,30 @@
 
 #define TITLE_ROTATION_FREQUENCY 5000 // rotate title every 5 sec
 
+#define DISPLAY_UPDATE_QUEUE_SIZE 8 // display lines the radio task can post before the housekeeping task draws them, power of two
+#define HOUSEKEEPING_INTERVAL 20 // ms the housekeeping task sleeps between passes
+#define HOUSEKEEPING_LOCK_WAIT 500 // ms housekeeping waits for chatter before skipping storage this pass
+
+// what can turn the screen back on, see setDisplayWakeEvents
+enum DisplayWakeEvent {
+  DisplayWakeButton = 0x01, // power key short press
+  DisplayWakePower = 0x02, // usb or battery connected/removed
+  DisplayWakeMessage = 0x04 // a message for this device arrived
+};
+
+#define DISPLAY_WAKE_DEFAULT (DisplayWakeButton | DisplayWakePower)
+
+enum ScreenState {
+  ScreenOn = 0,
+  ScreenOff = 1,
+  ScreenWaking = 2 // charge pump on, waiting for it to settle
+};
+
+struct DisplayUpdate {
+  uint8_t line;
+  char text[DISPLAY_LINE_WIDTH];
+};
+
 //#define MAX_USER_INPUT_LEN 1024
 //#define MAX_SUBSCRIPTIONS_PER_VIEW 3 // no more than 3 views can be notified
 
@@ -70,17 +104,23 @@ enum ControlMessagingStatus {
 
 class ControlLayer : public ChatterViewCallback {
   public:
-    ControlLayer (CallbackRegistry* _callbackRegistry);
+    ControlLayer (CallbackRegistry* _callbackRegistry, TimerWheel* _timers, StepRuntime* _runtime);
     ControlModeStatus getStatus () { return status; }
     void setControlMode (ControlMode* _control);
 
     ControlModeStatus initializeNextStep ();
     bool process (ChatterUserEvent evt);
+
+    // storage, gps and display work, run by the housekeeping task once the radio is up
+    bool startHousekeeping ();
+    void processHousekeeping ();
+    bool isHousekeepingRunning () { return housekeepingRunning; }
+    TaskLock* getChatterLock () { return &chatterLock; }
     //bool processForCurrentView ();
 
     void setMessagingPaused (bool paused) { messagingStatus = paused ? MessagingPaused : MessagingRunning; }
     void setPaused (bool paused) { status = paused ? ControlModePaused : ControlModeReady; }
-    bool isMessagingPaused () { return messagingStatus == MessagingPaused || (messagingPausedUntil != 0 && messagingPausedUntil > millis()); }
+    bool isMessagingPaused () { return messagingStatus == MessagingPaused || timers->isArmed(TimerMessagingPause); }
     void pauseMessagingFor(unsigned long pauseLengthMillis);
     //void setCurrentView (ChatterView view);
     //ChatterView getCurrentView () {return currentView;}
@@ -115,8 +155,15 @@ class ControlLayer : public ChatterViewCallback {
     //void userInteracted ();
 
     void setInitialized (bool _initialized) {initialized = _initialized;}
-    bool needsOnboarded () { return isClusterRoot; }
+    bool needsOnboarded () { return isClusterRoot && !onboarding; }
     bool joinCluster ();
+
+    // idles until the next deadline if the last cycle left nothing to do
+    void idle ();
+
+    // turns the screen back on (and restarts the timeout) if the event is one of the wake events
+    void wakeDisplay (DisplayWakeEvent event);
+    void setDisplayWakeEvents (uint8_t events) { displayWakeEvents = events; }
     void setColorForStatus (ChatStatus chatStatus);
     void resetColor ();
   protected:
@@ -140,6 +187,8 @@ class ControlLayer : public ChatterViewCallback {
     //ComponentRegistry* globalComponentRegistry;
     //ScreenRegistry* globalScreenRegistry;
     CallbackRegistry* globalCallbackRegistry;
+    TimerWheel* timers;
+    StepRuntime* runtime;
     //GlobalCache* globalCache;
 
     //bool getStorageSemaphore ();
@@ -148,13 +197,23 @@ class ControlLayer : public ChatterViewCallback {
     //SemaphoreHandle_t* storageSemaphore;
 
     bool initialized = false;
-    unsigned long messagingPausedUntil = 0;
     bool interruptedByUser = false;
 
     unsigned long lastUserInteraction = millis();
     unsigned long screenTimeout = 0; // replaced with setting after init
 
-    SH1106Wire* display;
+    // decided on the radio side, carried out by whichever task draws
+    uint8_t displayWakeEvents = DISPLAY_WAKE_DEFAULT;
+    volatile ScreenState screenState = ScreenOn;
+    std::atomic<bool> screenWakeRequested {false};
+    std::atomic<bool> screenSleepRequested {false};
+    unsigned long screenWakeAt = 0;
+    void applyScreenPower (); // drawing task only
+
+    SH1106Wire* display; // drawing only, frames reaches the panel
+    Sh1106FrameSink* frameSink;
+    FrameCompositor* frames;
+    LineLayoutCache layouts; // lines that were shown before are copied back rather than redrawn
 
     //NewClusterForm newClusterForm;
     DeviceInitializationForm deviceInitializationForm;
@@ -167,6 +226,7 @@ class ControlLayer : public ChatterViewCallback {
     void updateDisplay (const char* dispText, uint8_t line);
     void updateDisplay (const char lines[DISPLAY_NUM_LINES][DISPLAY_LINE_WIDTH]);
     void updateDisplay ();
+    void refreshDisplay (); // draws whatever status writes left behind, if a frame is due
 
     void updateTitle (const char* title);
     void updateSubtitle (const char* subtitle);
@@ -174,24 +234,42 @@ class ControlLayer : public ChatterViewCallback {
     void rotateDisplay ();
 
     TitleRotationItem currTitleItem = TitleAlias;
-    unsigned long titleLastRotation = 0;
     char titleLine[32];
 
     const char* getStatusName (ChatStatus chatStatus);
 
-    float meshCachePct = 0.0;
-    float generalProgress = 0.0;
+    // set from chatter callbacks on the radio task, drawn by housekeeping
+    std::atomic<float> meshCachePct {0.0};
+    std::atomic<float> generalProgress {0.0};
 
     float lastMeshCachePct = 0.0;
     float lastGeneralProgress = 0.0;
 
+    // everything that touches chatter (or the timer wheel) holds this
+    TaskLock chatterLock;
+    volatile bool housekeepingRunning = false;
+    bool housekeepingStartAttempted = false;
+    volatile bool housekeepingWaiting = false; // radio gives up the lock for a moment when set
+    TaskLock housekeepingPassLock; // held by the housekeeping task for each pass, the loop only light sleeps while it can take it
+    bool canSleepWithHousekeeping ();
+    std::atomic<bool> displayDirty {false};
+
+    // radio -> housekeeping. lines are held (latest wins) and posted once per cycle
+    SpscRing<DisplayUpdate, DISPLAY_UPDATE_QUEUE_SIZE> displayUpdates;
+    char pendingDisplayLines[DISPLAY_NUM_LINES][DISPLAY_LINE_WIDTH];
+    uint8_t pendingDisplayMask = 0;
+    void postDisplayLine (const char* dispText, uint8_t line);
+    void postPendingDisplayLines ();
+    static void housekeepingTask (void* arg);
+    volatile uintptr_t housekeepingTaskId = 0;
+
     bool isClusterRoot = true; // assume this is root until we are able to check
+    bool onboarding = false; // joining a cluster, control mode steps it each cycle
     bool ledRunning = false;
     bool displayRunning = false;
 
     ChatStatus lastChatStatus = ChatDisconnected;
     uint8_t lastNumNeighbors = 0;
-    uint32_t lastNeighborsUpdate = 0;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "IdleScheduler.h"
+
+IdleScheduler::IdleScheduler () {
+  reset();
+}
+
+void IdleScheduler::reset () {
+  started = false;
+  activeMicros = 0;
+  for (uint8_t mode = 0; mode < IDLE_MODE_COUNT; mode++) {
+    idleMicros[mode] = 0;
+  }
+  idleCount = 0;
+  radioWakes = 0;
+  shortWindows = 0;
+}
+
+bool IdleScheduler::idleFor (unsigned long windowMillis) {
+  unsigned long idleStart = TaskPlatform::nowMicros();
+  if (!started) {
+    started = true;
+    lastIdleEnd = idleStart;
+  }
+  unsigned long activeElapsed = idleStart - lastIdleEnd;
+
+  if (windowMillis < IDLE_MIN_WINDOW) {
+    // just run the next cycle
+    shortWindows++;
+    activeMicros += activeElapsed;
+    lastIdleEnd = idleStart;
+    return false;
+  }
+
+  if (windowMillis > IDLE_MAX_WINDOW) {
+    windowMillis = IDLE_MAX_WINDOW;
+  }
+
+  IdleMode mode = lightSleepAllowed ? IdleModeLightSleep : IdleModeBlocked;
+  bool radioWake = TaskPlatform::idleMillis(windowMillis, wakePin, mode == IdleModeLightSleep);
+
+  unsigned long idleEnd = TaskPlatform::nowMicros();
+  record(activeElapsed, idleEnd - idleStart, mode, radioWake);
+  lastIdleEnd = idleEnd;
+  return radioWake;
+}
+
+void IdleScheduler::simulateTrace (const unsigned long* arrivalMillis, uint16_t arrivalCount, unsigned long traceMillis, bool lightSleep) {
+  // arrivals need to be in time order
+  reset();
+  IdleMode mode = lightSleep ? IdleModeLightSleep : IdleModeBlocked;
+  unsigned long now = 0;
+  uint16_t nextArrival = 0;
+
+  while (now < traceMillis) {
+    // a cycle handles everything that has arrived so far
+    unsigned long active = IDLE_SIM_CYCLE_MILLIS;
+    while (nextArrival < arrivalCount && arrivalMillis[nextArrival] <= now) {
+      active += IDLE_SIM_HANDLE_MILLIS;
+      nextArrival++;
+    }
+    now += active;
+
+    // then idles until the window closes or the radio has something
+    unsigned long window = now < traceMillis ? traceMillis - now : 0;
+    if (window > IDLE_MAX_WINDOW) {
+      window = IDLE_MAX_WINDOW;
+    }
+    bool radioWake = false;
+    if (nextArrival < arrivalCount && arrivalMillis[nextArrival] < now + window) {
+      window = arrivalMillis[nextArrival] > now ? arrivalMillis[nextArrival] - now : 0;
+      radioWake = true;
+    }
+
+    if (window < IDLE_MIN_WINDOW) {
+      // the real loop would run straight through a window this short
+      shortWindows++;
+      activeMicros += (active + window) * 1000ul;
+    }
+    else {
+      record(active * 1000ul, window * 1000ul, mode, radioWake);
+    }
+    now += window;
+  }
+}
+
+void IdleScheduler::record (unsigned long activeElapsed, unsigned long idleElapsed, IdleMode mode, bool radioWake) {
+  activeMicros += activeElapsed;
+  idleMicros[mode] += idleElapsed;
+  idleCount++;
+  if (radioWake) {
+    radioWakes++;
+  }
+}
+
+uint64_t IdleScheduler::getTotalMicros () {
+  uint64_t total = activeMicros;
+  for (uint8_t mode = 0; mode < IDLE_MODE_COUNT; mode++) {
+    total += idleMicros[mode];
+  }
+  return total;
+}
+
+uint8_t IdleScheduler::getActivePercent () {
+  uint64_t total = getTotalMicros();
+  return total > 0 ? (uint8_t)((activeMicros * 100) / total) : 100;
+}
+
+uint16_t IdleScheduler::getAverageMilliamps () {
+  uint64_t total = getTotalMicros();
+  if (total == 0) {
+    return IDLE_ACTIVE_MILLIAMPS;
+  }
+
+  uint64_t weighted = activeMicros * IDLE_ACTIVE_MILLIAMPS
+    + idleMicros[IdleModeBlocked] * IDLE_BLOCKED_MILLIAMPS
+    + idleMicros[IdleModeLightSleep] * IDLE_LIGHT_SLEEP_MILLIAMPS;
+  return (uint16_t)(weighted / total);
+}
+
+uint8_t IdleScheduler::getProjectedSavingsPercent () {
+  uint64_t total = getTotalMicros();
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t weighted = activeMicros * IDLE_ACTIVE_MILLIAMPS
+    + idleMicros[IdleModeBlocked] * IDLE_BLOCKED_MILLIAMPS
+    + idleMicros[IdleModeLightSleep] * IDLE_LIGHT_SLEEP_MILLIAMPS;
+  return (uint8_t)(100 - (weighted * 100) / (total * IDLE_ACTIVE_MILLIAMPS));
+}
+
+int IdleScheduler::writeSummary (char* buffer, int maxLength) {
+  uint64_t total = getTotalMicros();
+  uint8_t blockedPercent = total > 0 ? (uint8_t)((idleMicros[IdleModeBlocked] * 100) / total) : 0;
+  uint8_t sleepPercent = total > 0 ? (uint8_t)((idleMicros[IdleModeLightSleep] * 100) / total) : 0;
+  int pos = snprintf(buffer, maxLength, "Idle: active %d%% blocked %d%% sleep %d%%, ~%dmA (save %d%%), radio wakes %lu/%lu",
+    getActivePercent(), blockedPercent, sleepPercent, getAverageMilliamps(), getProjectedSavingsPercent(), radioWakes, idleCount);
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,75 @@
+#include "TaskPlatform.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef IDLESCHEDULER_H
+#define IDLESCHEDULER_H
+
+#define IDLE_MIN_WINDOW 20 // ms, shorter waits aren't worth the sleep entry and exit
+#define IDLE_MAX_WINDOW 1000 // ms, chatter's own mesh and ping timing isn't on the wheel, so check back at least this often
+
+// rough esp32 draw for the energy projection, the radio sits in rx either way so it isn't counted
+#define IDLE_ACTIVE_MILLIAMPS 50 // loop running
+#define IDLE_BLOCKED_MILLIAMPS 20 // loop task blocked, idle task waiting on interrupts
+#define IDLE_LIGHT_SLEEP_MILLIAMPS 2 // both cores stopped
+
+#define IDLE_SIM_HANDLE_MILLIS 40 // simulated time to receive and answer one message
+#define IDLE_SIM_CYCLE_MILLIS 5 // simulated cost of a control cycle that finds nothing to do
+
+enum IdleMode {
+  IdleModeBlocked = 0,
+  IdleModeLightSleep = 1
+};
+
+#define IDLE_MODE_COUNT 2
+
+/**
+ * Decides how long the loop can idle between control cycles, waits it out
+ * (light sleep when allowed, otherwise blocked), and keeps duty cycle stats.
+ * Active time is whatever passes between one idle and the next. The same
+ * accounting can be driven by a recorded list of message arrivals, which
+ * gives the projected savings for that traffic without a device.
+ */
+class IdleScheduler {
+  public:
+    IdleScheduler ();
+
+    void setWakePin (int16_t pin) { wakePin = pin; }
+    void setLightSleepAllowed (bool allowed) { lightSleepAllowed = allowed; }
+    bool isLightSleepAllowed () { return lightSleepAllowed; }
+
+    // idles for the window (clamped to IDLE_MAX_WINDOW), returns true if the radio ended it early
+    bool idleFor (unsigned long windowMillis);
+
+    // replays message arrivals (ms from the start of the trace) through the same policy, the
+    // results replace the current stats
+    void simulateTrace (const unsigned long* arrivalMillis, uint16_t arrivalCount, unsigned long traceMillis, bool lightSleep);
+    void reset ();
+
+    uint8_t getActivePercent ();
+    uint16_t getAverageMilliamps ();
+    uint8_t getProjectedSavingsPercent (); // against a loop that never idles
+    unsigned long getIdleCount () { return idleCount; }
+    unsigned long getRadioWakeCount () { return radioWakes; }
+    unsigned long getShortWindowCount () { return shortWindows; }
+
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    int16_t wakePin = TASK_NO_WAKE_PIN;
+    bool lightSleepAllowed = false;
+
+    bool started = false;
+    unsigned long lastIdleEnd = 0; // micros
+
+    uint64_t activeMicros = 0;
+    uint64_t idleMicros[IDLE_MODE_COUNT];
+    unsigned long idleCount = 0;
+    unsigned long radioWakes = 0;
+    unsigned long shortWindows = 0; // windows below IDLE_MIN_WINDOW that were spent running
+
+    void record (unsigned long activeElapsed, unsigned long idleElapsed, IdleMode mode, bool radioWake);
+    uint64_t getTotalMicros ();
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <atomic>
+#include "TaskPlatform.h"
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#ifdef TASK_PLATFORM_FREERTOS
+#define SPSC_CACHE_LINE 32 // esp32 cache line
+#else
+#define SPSC_CACHE_LINE 64
+#endif
+
+/**
+ * Single producer, single consumer ring. Neither side ever blocks or takes a
+ * lock: the producer only writes the tail, the consumer only writes the head,
+ * and each publishes with release and reads the other's index with acquire.
+ * The two indices sit on separate cache lines so the cores don't fight over
+ * one line. Capacity must be a power of two.
+ *
+ * claim/publish and front/release work on the slot in place, for records that
+ * are too big to copy twice.
+ */
+template <typename T, uint16_t Capacity>
+class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+  public:
+    SpscRing () : headIndex(0), tailIndex(0) {}
+
+    /** producer side **/
+    bool push (const T& item) {
+      T* slot = claim();
+      if (slot == nullptr) {
+        return false;
+      }
+      *slot = item;
+      publish();
+      return true;
+    }
+
+    // slot to fill in, null if full. publish() hands it to the consumer
+    T* claim () {
+      uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+      if (tail - headIndex.load(std::memory_order_acquire) >= Capacity) {
+        return nullptr;
+      }
+      return &items[tail & (Capacity - 1)];
+    }
+
+    void publish () {
+      tailIndex.store(tailIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** consumer side **/
+    bool pop (T& item) {
+      T* slot = front();
+      if (slot == nullptr) {
+        return false;
+      }
+      item = *slot;
+      release();
+      return true;
+    }
+
+    // oldest published slot, null if empty. release() gives it back to the producer
+    T* front () {
+      uint32_t head = headIndex.load(std::memory_order_relaxed);
+      if (head == tailIndex.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      return &items[head & (Capacity - 1)];
+    }
+
+    void release () {
+      headIndex.store(headIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** either side, only a snapshot **/
+    uint16_t getCount () { return (uint16_t)(tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire)); }
+    bool isEmpty () { return getCount() == 0; }
+
+  protected:
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> headIndex; // written by the consumer
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> tailIndex; // written by the producer
+    alignas(SPSC_CACHE_LINE) T items[Capacity];
+};
+
+#endif
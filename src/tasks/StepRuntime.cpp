@@ -0,0 +1,81 @@
+#include "StepRuntime.h"
+
+StepRuntime::StepRuntime (StepClock _clock) {
+  clock = _clock;
+}
+
+bool StepRuntime::start (StepTask* task) {
+  task->stage = 0;
+  task->finished = false;
+  task->wakeTime = clock();
+
+  if (isRunning(task)) {
+    return true;
+  }
+  if (count >= STEP_RUNTIME_MAX_TASKS) {
+    // caller decides what to do, this has no logger so it can run off-device
+    task->finished = true;
+    return false;
+  }
+  tasks[count++] = task;
+  return true;
+}
+
+void StepRuntime::stop (StepTask* task) {
+  task->finished = true;
+  for (uint8_t i = 0; i < count; i++) {
+    if (tasks[i] == task) {
+      tasks[i] = tasks[--count];
+      return;
+    }
+  }
+}
+
+bool StepRuntime::isRunning (StepTask* task) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (tasks[i] == task) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t StepRuntime::runDue () {
+  uint8_t stepped = 0;
+  unsigned long now = clock();
+
+  uint8_t i = 0;
+  while (i < count) {
+    StepTask* task = tasks[i];
+    if ((long)(now - task->wakeTime) >= 0) {
+      task->step(now);
+      stepped++;
+    }
+
+    if (task->finished) {
+      // the last one takes this slot, so check this index again
+      tasks[i] = tasks[--count];
+    }
+    else {
+      i++;
+    }
+  }
+  return stepped;
+}
+
+unsigned long StepRuntime::getMillisUntilNext () {
+  if (count == 0) {
+    return STEP_FINISHED;
+  }
+
+  unsigned long now = clock();
+  unsigned long soonest = STEP_FINISHED;
+  for (uint8_t i = 0; i < count; i++) {
+    long remaining = (long)(tasks[i]->wakeTime - now);
+    unsigned long untilWake = remaining > 0 ? (unsigned long)remaining : 0;
+    if (untilWake < soonest) {
+      soonest = untilWake;
+    }
+  }
+  return soonest;
+}
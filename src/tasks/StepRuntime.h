@@ -0,0 +1,97 @@
+#include "TaskPlatform.h"
+
+#ifndef STEPRUNTIME_H
+#define STEPRUNTIME_H
+
+#define STEP_RUNTIME_MAX_TASKS 8 // step tasks that can be running at once
+#define STEP_FINISHED 0xFFFFFFFFul // returned by a step function that is done
+
+typedef unsigned long (*StepClock) ();
+typedef unsigned long (*StepFunction) (); // runs one step, returns ms until the next one or STEP_FINISHED
+
+/**
+ * A flow that used to block in delay(), cut into steps. Each call to step
+ * does a bit of work, records where to pick up next (the stage), and says
+ * when it wants to run again with sleepFor/sleepUntil, or finish(). A step
+ * that does none of those runs again on the next pass.
+ */
+class StepTask {
+  public:
+    virtual void step (unsigned long now) = 0;
+
+    uint8_t getStage () { return stage; }
+    void setStage (uint8_t _stage) { stage = _stage; }
+    void sleepFor (unsigned long now, unsigned long sleepMillis) { wakeTime = now + sleepMillis; }
+    void sleepUntil (unsigned long deadline) { wakeTime = deadline; }
+    void finish () { finished = true; }
+
+    bool isFinished () { return finished; }
+    unsigned long getWakeTime () { return wakeTime; }
+
+  protected:
+    uint8_t stage = 0;
+    unsigned long wakeTime = 0;
+    bool finished = true;
+
+  friend class StepRuntime;
+};
+
+// step task around a plain function, the function returns how long to sleep
+class StepFunctionTask : public StepTask {
+  public:
+    StepFunctionTask (StepFunction _function) { function = _function; }
+
+    void step (unsigned long now) {
+      unsigned long sleepMillis = function();
+      if (sleepMillis == STEP_FINISHED) {
+        finish();
+      }
+      else {
+        sleepFor(now, sleepMillis);
+      }
+    }
+
+  protected:
+    StepFunction function;
+};
+
+// step task around a member function, so a flow can live in the class it belongs to
+template <typename T>
+class StepMethodTask : public StepTask {
+  public:
+    typedef void (T::*StepMethod) (StepTask* task, unsigned long now);
+    StepMethodTask (T* _owner, StepMethod _method) { owner = _owner; method = _method; }
+
+    void step (unsigned long now) { (owner->*method)(this, now); }
+
+  protected:
+    T* owner;
+    StepMethod method;
+};
+
+/**
+ * Runs step tasks cooperatively from the main loop, so waits no longer keep
+ * the loop (and the radio with it) from running. The clock can be swapped
+ * out, so flows can be stepped against a fake clock off-device.
+ */
+class StepRuntime {
+  public:
+    StepRuntime (StepClock _clock = TaskPlatform::nowMillis);
+
+    // (re)starts the task from stage 0, it runs on the next pass
+    bool start (StepTask* task);
+    void stop (StepTask* task);
+    bool isRunning (StepTask* task);
+
+    // steps every task whose wake time has come, returns how many ran
+    uint8_t runDue ();
+    unsigned long getMillisUntilNext (); // STEP_FINISHED if nothing is running
+    uint8_t getCount () { return count; }
+
+  protected:
+    StepTask* tasks[STEP_RUNTIME_MAX_TASKS];
+    uint8_t count = 0;
+    StepClock clock;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "TaskPlatform.h"
+
+TaskLockGuard::TaskLockGuard (TaskLock* _lock, unsigned long* waitedMicros) {
+  lock = _lock;
+  *waitedMicros = 0;
+  if (!lock->tryLock()) {
+    unsigned long waitStart = TaskPlatform::nowMicros();
+    lock->lock();
+    *waitedMicros = TaskPlatform::nowMicros() - waitStart;
+  }
+}
+
+#ifdef TASK_PLATFORM_FREERTOS
+
+TaskLock::TaskLock () {
+  mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+void TaskLock::lock () {
+  xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+}
+
+void TaskLock::unlock () {
+  xSemaphoreGiveRecursive(mutex);
+}
+
+bool TaskLock::tryLock (uint32_t waitMillis) {
+  return xSemaphoreTakeRecursive(mutex, pdMS_TO_TICKS(waitMillis)) == pdTRUE;
+}
+
+bool TaskPlatform::startTask (const char* name, TaskEntry entry, void* arg, uint32_t stackSize, uint8_t priority, int8_t core) {
+  TaskHandle_t handle;
+  return xTaskCreatePinnedToCore(entry, name, stackSize, arg, priority, &handle, core) == pdPASS;
+}
+
+void TaskPlatform::sleepMillis (uint32_t millisToSleep) {
+  // always give up at least one tick so the idle task (and its watchdog) gets to run
+  TickType_t ticks = pdMS_TO_TICKS(millisToSleep);
+  vTaskDelay(ticks > 0 ? ticks : 1);
+}
+
+uintptr_t TaskPlatform::currentTaskId () {
+  return (uintptr_t)xTaskGetCurrentTaskHandle();
+}
+
+unsigned long TaskPlatform::nowMicros () {
+  return micros();
+}
+
+unsigned long TaskPlatform::nowMillis () {
+  return millis();
+}
+
+bool TaskPlatform::idleMillis (uint32_t millisToIdle, int16_t wakePin, bool lightSleep) {
+  if (wakePin != TASK_NO_WAKE_PIN && digitalRead(wakePin) == HIGH) {
+    // already raised (and not cleared by the driver), it can't wake us, so only the timer can
+    wakePin = TASK_NO_WAKE_PIN;
+  }
+
+  if (lightSleep) {
+    esp_sleep_enable_timer_wakeup((uint64_t)millisToIdle * 1000ull);
+    if (wakePin != TASK_NO_WAKE_PIN) {
+      gpio_wakeup_enable((gpio_num_t)wakePin, GPIO_INTR_HIGH_LEVEL);
+      esp_sleep_enable_gpio_wakeup();
+    }
+
+    esp_light_sleep_start();
+    bool pinWake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    if (wakePin != TASK_NO_WAKE_PIN) {
+      // level wakeup replaced the radio driver's edge interrupt, put it back
+      gpio_wakeup_disable((gpio_num_t)wakePin);
+      gpio_set_intr_type((gpio_num_t)wakePin, GPIO_INTR_POSEDGE);
+    }
+    return pinWake;
+  }
+
+  // blocked, the idle task gets the core. the pin is checked every tick
+  unsigned long idleStart = millis();
+  while (millis() - idleStart < millisToIdle) {
+    if (wakePin != TASK_NO_WAKE_PIN && digitalRead(wakePin) == HIGH) {
+      return true;
+    }
+    vTaskDelay(1);
+  }
+  return false;
+}
+
+#else
+
+TaskLock::TaskLock () {
+}
+
+void TaskLock::lock () {
+  mutex.lock();
+}
+
+void TaskLock::unlock () {
+  mutex.unlock();
+}
+
+bool TaskLock::tryLock (uint32_t waitMillis) {
+  return mutex.try_lock_for(std::chrono::milliseconds(waitMillis));
+}
+
+bool TaskPlatform::startTask (const char* name, TaskEntry entry, void* arg, uint32_t stackSize, uint8_t priority, int8_t core) {
+  // threads aren't named, sized or pinned on the host
+  (void)name; (void)stackSize; (void)priority; (void)core;
+  std::thread task(entry, arg);
+  task.detach();
+  return true;
+}
+
+void TaskPlatform::sleepMillis (uint32_t millisToSleep) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(millisToSleep));
+}
+
+uintptr_t TaskPlatform::currentTaskId () {
+  uintptr_t id = (uintptr_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+  return id != 0 ? id : 1;
+}
+
+unsigned long TaskPlatform::nowMicros () {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long TaskPlatform::nowMillis () {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool TaskPlatform::idleMillis (uint32_t millisToIdle, int16_t wakePin, bool lightSleep) {
+  // no radio on the host, the whole window is always slept
+  (void)wakePin; (void)lightSleep;
+  sleepMillis(millisToIdle);
+  return false;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#if defined(ARDUINO_ARCH_ESP32) && !defined(TASK_PLATFORM_HOST)
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#define TASK_PLATFORM_FREERTOS
+#else
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <functional>
+#endif
+
+#ifndef TASKPLATFORM_H
+#define TASKPLATFORM_H
+
+#define TASK_RADIO_CORE 1 // arduino loop task, radio stays here
+#define TASK_HOUSEKEEPING_CORE 0
+#define TASK_HOUSEKEEPING_STACK 8192
+#define TASK_HOUSEKEEPING_PRIORITY 1 // same as the loop task
+#define TASK_NO_WAKE_PIN -1
+
+typedef void (*TaskEntry)(void* arg);
+
+/**
+ * Recursive lock, so the owner can call back into code that takes it again.
+ * FreeRTOS recursive mutex on the ESP32, std::recursive_mutex on the host.
+ */
+class TaskLock {
+  public:
+    TaskLock ();
+    void lock ();
+    void unlock ();
+    bool tryLock (uint32_t waitMillis = 0);
+
+  protected:
+    #ifdef TASK_PLATFORM_FREERTOS
+    SemaphoreHandle_t mutex;
+    #else
+    std::recursive_timed_mutex mutex;
+    #endif
+};
+
+// holds a TaskLock for the life of the guard
+class TaskLockGuard {
+  public:
+    TaskLockGuard (TaskLock* _lock) { lock = _lock; lock->lock(); }
+
+    // same, but reports how long it had to wait (0 if the lock was free)
+    TaskLockGuard (TaskLock* _lock, unsigned long* waitedMicros);
+    ~TaskLockGuard () { lock->unlock(); }
+
+  protected:
+    TaskLock* lock;
+};
+
+/**
+ * The little bit of task handling the control layer needs. On the ESP32 a
+ * task is pinned to a core, on the host (to run and benchmark the split on
+ * linux) it's a detached std::thread and the core is ignored.
+ */
+class TaskPlatform {
+  public:
+    static bool startTask (const char* name, TaskEntry entry, void* arg, uint32_t stackSize, uint8_t priority, int8_t core);
+    static void sleepMillis (uint32_t millisToSleep);
+    static uintptr_t currentTaskId (); // identifies the calling task, never 0
+    static unsigned long nowMicros ();
+    static unsigned long nowMillis ();
+
+    // waits up to millisToIdle, or until wakePin goes high. light sleep stops
+    // both cores, so it's only for when nothing else is running. returns true
+    // if the pin ended the wait
+    static bool idleMillis (uint32_t millisToIdle, int16_t wakePin, bool lightSleep);
+};
+
+#endif
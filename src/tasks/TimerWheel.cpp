@@ -0,0 +1,252 @@
+#include "TimerWheel.h"
+
+#define TIMER_WHEEL_TICK_MILLIS (1ul << TIMER_WHEEL_TICK_SHIFT)
+
+TimerWheel::TimerWheel () {
+  for (uint8_t id = 0; id < TIMER_WHEEL_MAX_TIMERS; id++) {
+    timers[id].state = TimerIdle;
+    timers[id].deadline = 0;
+    timers[id].next = TIMER_WHEEL_NONE;
+    timers[id].level = TIMER_WHEEL_NONE;
+    timers[id].slot = TIMER_WHEEL_NONE;
+    timers[id].lastLateness = 0;
+    timers[id].worstLateness = 0;
+    timers[id].worstEarliness = 0;
+    timers[id].fireCount = 0;
+  }
+
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+      slots[level][slot] = TIMER_WHEEL_NONE;
+    }
+  }
+
+  currentTick = 0;
+  lastAdvance = millis();
+}
+
+void TimerWheel::schedule (TimerId id, unsigned long delayMillis) {
+  scheduleAt(id, millis() + delayMillis);
+}
+
+void TimerWheel::scheduleAt (TimerId id, unsigned long deadline) {
+  if (timers[id].state == TimerArmed) {
+    unlink(id);
+  }
+  else if (timers[id].state == TimerDue) {
+    dueCount--;
+  }
+
+  timers[id].deadline = deadline;
+  timers[id].state = TimerArmed;
+  insert(id, millis());
+}
+
+void TimerWheel::scheduleEarliest (TimerId id, unsigned long deadline) {
+  if (timers[id].state == TimerDue) {
+    // already due, can't get any earlier
+    return;
+  }
+  if (timers[id].state == TimerArmed && deadlineReached(deadline, timers[id].deadline)) {
+    return;
+  }
+  scheduleAt(id, deadline);
+}
+
+void TimerWheel::extend (TimerId id, unsigned long delayMillis) {
+  unsigned long deadline = millis() + delayMillis;
+  if (timers[id].state == TimerArmed && deadlineReached(timers[id].deadline, deadline)) {
+    // existing deadline is already later, don't shorten it
+    return;
+  }
+  scheduleAt(id, deadline);
+}
+
+void TimerWheel::cancel (TimerId id) {
+  if (timers[id].state == TimerArmed) {
+    unlink(id);
+  }
+  else if (timers[id].state == TimerDue) {
+    dueCount--;
+  }
+  timers[id].state = TimerIdle;
+}
+
+bool TimerWheel::consume (TimerId id) {
+  if (timers[id].state == TimerDue) {
+    timers[id].state = TimerIdle;
+    dueCount--;
+    return true;
+  }
+  return false;
+}
+
+unsigned long TimerWheel::getMillisUntilNext (unsigned long now) {
+  if (dueCount > 0) {
+    return 0;
+  }
+
+  unsigned long nextMillis = TIMER_WHEEL_IDLE;
+  for (uint8_t id = 0; id < TIMER_WHEEL_MAX_TIMERS; id++) {
+    if (timers[id].state == TimerArmed) {
+      long remaining = millisUntil(now, timers[id].deadline);
+      unsigned long untilThis = remaining > 0 ? (unsigned long)remaining : 0;
+      if (untilThis < nextMillis) {
+        nextMillis = untilThis;
+      }
+    }
+  }
+  return nextMillis;
+}
+
+uint8_t TimerWheel::advance (unsigned long now) {
+  uint8_t dueBefore = dueCount;
+  long elapsed = (long)(now - lastAdvance);
+  if (elapsed < (long)TIMER_WHEEL_TICK_MILLIS) {
+    return 0;
+  }
+
+  unsigned long steps = (unsigned long)elapsed >> TIMER_WHEEL_TICK_SHIFT;
+
+  if (steps > TIMER_WHEEL_MAX_CATCHUP_TICKS) {
+    // the loop was stalled for a while, cheaper to re-sort everything
+    currentTick += steps;
+    lastAdvance += steps << TIMER_WHEEL_TICK_SHIFT;
+    rehash(now);
+  }
+  else {
+    for (unsigned long step = 0; step < steps; step++) {
+      currentTick++;
+      lastAdvance += TIMER_WHEEL_TICK_MILLIS;
+
+      if ((currentTick & TIMER_WHEEL_SLOT_MASK) == 0) {
+        if (((currentTick >> TIMER_WHEEL_SLOT_BITS) & TIMER_WHEEL_SLOT_MASK) == 0) {
+          cascade(2, now);
+        }
+        cascade(1, now);
+      }
+
+      // everything left in this level 0 slot expires on this tick
+      uint8_t slot = currentTick & TIMER_WHEEL_SLOT_MASK;
+      int8_t id = slots[0][slot];
+      slots[0][slot] = TIMER_WHEEL_NONE;
+      while (id != TIMER_WHEEL_NONE) {
+        int8_t next = timers[id].next;
+        timers[id].next = TIMER_WHEEL_NONE;
+        expire(id, now);
+        id = next;
+      }
+    }
+  }
+
+  return dueCount - dueBefore;
+}
+
+void TimerWheel::insert (uint8_t id, unsigned long now) {
+  WheelTimer* timer = &timers[id];
+  long delta = (long)(timer->deadline - lastAdvance);
+  if (delta <= 0) {
+    expire(id, now);
+    return;
+  }
+
+  // round up, so a timer never fires before its deadline tick
+  uint32_t ticks = ((unsigned long)delta + TIMER_WHEEL_TICK_MILLIS - 1) >> TIMER_WHEEL_TICK_SHIFT;
+  uint32_t expiryTick = currentTick + ticks;
+
+  if (ticks < TIMER_WHEEL_SLOTS) {
+    timer->level = 0;
+    timer->slot = expiryTick & TIMER_WHEEL_SLOT_MASK;
+  }
+  else if (ticks < (1ul << (2 * TIMER_WHEEL_SLOT_BITS))) {
+    timer->level = 1;
+    timer->slot = (expiryTick >> TIMER_WHEEL_SLOT_BITS) & TIMER_WHEEL_SLOT_MASK;
+  }
+  else if (ticks < (1ul << (3 * TIMER_WHEEL_SLOT_BITS))) {
+    timer->level = 2;
+    timer->slot = (expiryTick >> (2 * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  }
+  else {
+    // further out than the wheel covers, park it in the outermost slot
+    // and it will be re-sorted when that slot cascades
+    timer->level = 2;
+    timer->slot = (currentTick >> (2 * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  }
+
+  timer->next = slots[timer->level][timer->slot];
+  slots[timer->level][timer->slot] = id;
+}
+
+void TimerWheel::unlink (uint8_t id) {
+  int8_t* link = &slots[timers[id].level][timers[id].slot];
+  while (*link != TIMER_WHEEL_NONE) {
+    if (*link == id) {
+      *link = timers[id].next;
+      break;
+    }
+    link = &timers[*link].next;
+  }
+  timers[id].next = TIMER_WHEEL_NONE;
+}
+
+void TimerWheel::expire (uint8_t id, unsigned long now) {
+  WheelTimer* timer = &timers[id];
+  timer->state = TimerDue;
+  timer->level = TIMER_WHEEL_NONE;
+  timer->slot = TIMER_WHEEL_NONE;
+  dueCount++;
+
+  timer->lastLateness = (long)(now - timer->deadline);
+  if (timer->lastLateness > timer->worstLateness) {
+    timer->worstLateness = timer->lastLateness;
+  }
+  if (timer->lastLateness < timer->worstEarliness) {
+    timer->worstEarliness = timer->lastLateness;
+  }
+  timer->fireCount++;
+}
+
+void TimerWheel::cascade (uint8_t level, unsigned long now) {
+  uint8_t slot = (currentTick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  int8_t id = slots[level][slot];
+  slots[level][slot] = TIMER_WHEEL_NONE;
+
+  // re-insert relative to the current tick, they'll land on a lower level
+  while (id != TIMER_WHEEL_NONE) {
+    int8_t next = timers[id].next;
+    timers[id].next = TIMER_WHEEL_NONE;
+    insert(id, now);
+    id = next;
+  }
+}
+
+void TimerWheel::rehash (unsigned long now) {
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+      slots[level][slot] = TIMER_WHEEL_NONE;
+    }
+  }
+
+  for (uint8_t id = 0; id < TIMER_WHEEL_MAX_TIMERS; id++) {
+    if (timers[id].state == TimerArmed) {
+      timers[id].next = TIMER_WHEEL_NONE;
+      insert(id, now);
+    }
+  }
+}
+
+const char* TimerWheel::getTimerName (TimerId id) {
+  const char* timerNames[TIMER_WHEEL_MAX_TIMERS] = {"out", "flush", "gps", "title", "pause", "nbrs", "home", "onboard", "screen", "prune"};
+  return timerNames[id] != nullptr ? timerNames[id] : "other";
+}
+
+int TimerWheel::writeSummary (char* buffer, int maxLength) {
+  int pos = snprintf(buffer, maxLength, "Timers fired late/early ms");
+  for (uint8_t id = 0; id < TIMER_WHEEL_MAX_TIMERS && pos < maxLength; id++) {
+    if (timers[id].fireCount > 0) {
+      pos += snprintf(buffer + pos, maxLength - pos, " %s:%lu %+ld/%ld",
+        getTimerName((TimerId)id), timers[id].fireCount, timers[id].worstLateness, timers[id].worstEarliness);
+    }
+  }
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#define TIMER_WHEEL_TICK_SHIFT 4 // 16 ms per tick
+#define TIMER_WHEEL_SLOT_BITS 5
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS) // slots per level
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 3 // 512 ms, 16 s, ~9 min before timers are parked in the outer slot
+#define TIMER_WHEEL_MAX_CATCHUP_TICKS 1024 // beyond this, rehash instead of stepping every tick
+
+#define TIMER_WHEEL_MAX_TIMERS 16
+#define TIMER_WHEEL_NONE -1
+#define TIMER_WHEEL_IDLE 0xFFFFFFFFul // nothing scheduled
+
+// every millis() based deadline in the node has one of these
+enum TimerId {
+  TimerOutbound = 0, // earliest scheduled outbound message
+  TimerStorageFlush = 1, // earliest storage zone flush
+  TimerGpsRefresh = 2, // next location sample
+  TimerTitleRotation = 3,
+  TimerMessagingPause = 4,
+  TimerNeighborsUpdate = 5,
+  TimerHomeShow = 6,
+  TimerOnboard = 7, // onboard init retry, then the exchange timeout
+  TimerScreenTimeout = 8,
+  TimerStoragePrune = 9 // the deferred startup prune
+};
+
+enum TimerState {
+  TimerIdle = 0,
+  TimerArmed = 1,
+  TimerDue = 2
+};
+
+/**
+ * Hierarchical timer wheel. The control layer calls advance() once per
+ * iteration, which moves any expired timers into the due state. Owners
+ * then consume() their timer rather than comparing millis() themselves.
+ * All deadline math is done on differences, so it's safe across the
+ * millis() rollover.
+ */
+class TimerWheel {
+  public:
+    TimerWheel ();
+
+    void schedule (TimerId id, unsigned long delayMillis);
+    void scheduleAt (TimerId id, unsigned long deadline);
+    void scheduleEarliest (TimerId id, unsigned long deadline); // only moves a timer earlier
+    void extend (TimerId id, unsigned long delayMillis); // only moves a timer later
+    void cancel (TimerId id);
+
+    // moves expired timers to due, returns how many became due
+    uint8_t advance (unsigned long now);
+
+    TimerState getState (TimerId id) { return timers[id].state; }
+    bool isIdle (TimerId id) { return timers[id].state == TimerIdle; }
+    bool isArmed (TimerId id) { return timers[id].state == TimerArmed; }
+    bool isDue (TimerId id) { return timers[id].state == TimerDue; }
+    bool consume (TimerId id); // true once, after the timer is due
+    bool hasDue () { return dueCount > 0; }
+
+    unsigned long getDeadline (TimerId id) { return timers[id].deadline; }
+    unsigned long getMillisUntilNext (unsigned long now);
+
+    // how far from the deadline the timer actually fired, negative is early
+    long getLastLateness (TimerId id) { return timers[id].lastLateness; }
+    long getWorstLateness (TimerId id) { return timers[id].worstLateness; }
+    long getWorstEarliness (TimerId id) { return timers[id].worstEarliness; }
+    unsigned long getFireCount (TimerId id) { return timers[id].fireCount; }
+
+    // fires and worst late/early ms of each timer that has fired
+    int writeSummary (char* buffer, int maxLength);
+    static const char* getTimerName (TimerId id);
+
+    static bool deadlineReached (unsigned long now, unsigned long deadline) { return (long)(now - deadline) >= 0; }
+    static long millisUntil (unsigned long now, unsigned long deadline) { return (long)(deadline - now); }
+
+  protected:
+    struct WheelTimer {
+      TimerState state;
+      unsigned long deadline;
+      int8_t next;
+      int8_t level;
+      int8_t slot;
+
+      long lastLateness;
+      long worstLateness;
+      long worstEarliness;
+      unsigned long fireCount;
+    };
+
+    WheelTimer timers[TIMER_WHEEL_MAX_TIMERS];
+    int8_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint32_t currentTick;
+    unsigned long lastAdvance;
+    uint8_t dueCount = 0;
+
+    void insert (uint8_t id, unsigned long now);
+    void unlink (uint8_t id);
+    void expire (uint8_t id, unsigned long now);
+    void cascade (uint8_t level, unsigned long now);
+    void rehash (unsigned long now);
+};
+
+#endif
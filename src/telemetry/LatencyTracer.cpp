@@ -0,0 +1,141 @@
+#include "LatencyTracer.h"
+
+LatencyTracer::LatencyTracer () {
+  memset(traces, 0, sizeof(traces));
+  memset(histograms, 0, sizeof(histograms));
+  memset(counts, 0, sizeof(counts));
+}
+
+uint16_t LatencyTracer::begin (unsigned long detectedMicros) {
+  uint16_t traceId = nextSeq++;
+  if (nextSeq == LATENCY_TRACE_NONE) {
+    nextSeq = 1;
+  }
+
+  LatencyTrace* trace = &traces[traceId % LATENCY_TRACE_RING_SIZE];
+  trace->seq = traceId;
+  trace->outstanding = 1; // dispatch itself
+  trace->detected = detectedMicros;
+  trace->retrieved = 0;
+  trace->executed = 0;
+  trace->lastEvent = detectedMicros;
+  return traceId;
+}
+
+LatencyTracer::LatencyTrace* LatencyTracer::find (uint16_t traceId) {
+  if (traceId == LATENCY_TRACE_NONE) {
+    return nullptr;
+  }
+  LatencyTrace* trace = &traces[traceId % LATENCY_TRACE_RING_SIZE];
+  if (trace->seq != traceId || trace->outstanding == 0) {
+    return nullptr;
+  }
+  return trace;
+}
+
+void LatencyTracer::retrieved (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    trace->retrieved = TaskPlatform::nowMicros();
+    trace->lastEvent = trace->retrieved;
+    record(LatencyStageRetrieve, trace->retrieved - trace->detected);
+  }
+}
+
+void LatencyTracer::expect (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    trace->outstanding++;
+  }
+}
+
+void LatencyTracer::ackSent (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    unsigned long now = TaskPlatform::nowMicros();
+    record(LatencyStageAck, now - trace->retrieved);
+    finishEvent(trace, now);
+  }
+}
+
+void LatencyTracer::executed (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    trace->executed = TaskPlatform::nowMicros();
+    trace->lastEvent = trace->executed;
+    record(LatencyStageExecute, trace->executed - trace->retrieved);
+  }
+}
+
+void LatencyTracer::replySent (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    unsigned long now = TaskPlatform::nowMicros();
+    record(LatencyStageReply, now - (trace->executed != 0 ? trace->executed : trace->retrieved));
+    finishEvent(trace, now);
+  }
+}
+
+void LatencyTracer::release (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    finishEvent(trace, trace->lastEvent);
+  }
+}
+
+void LatencyTracer::discard (uint16_t traceId) {
+  LatencyTrace* trace = find(traceId);
+  if (trace != nullptr) {
+    trace->outstanding = 0;
+  }
+}
+
+void LatencyTracer::finishEvent (LatencyTrace* trace, unsigned long now) {
+  if ((long)(now - trace->lastEvent) > 0) {
+    trace->lastEvent = now;
+  }
+  trace->outstanding--;
+  if (trace->outstanding == 0) {
+    record(LatencyStageTotal, trace->lastEvent - trace->detected);
+  }
+}
+
+void LatencyTracer::record (LatencyStage stage, unsigned long elapsedMicros) {
+  uint8_t bucket = 0;
+  while (elapsedMicros > 1 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+    elapsedMicros >>= 1;
+    bucket++;
+  }
+  histograms[stage][bucket]++;
+  counts[stage]++;
+}
+
+unsigned long LatencyTracer::getPercentile (LatencyStage stage, uint8_t percentile) {
+  if (counts[stage] == 0) {
+    return 0;
+  }
+
+  // first bucket where the running count reaches the target
+  unsigned long target = (counts[stage] * percentile + 99) / 100;
+  unsigned long runningCount = 0;
+  for (uint8_t bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++) {
+    runningCount += histograms[stage][bucket];
+    if (runningCount >= target) {
+      return (2ul << bucket) - 1;
+    }
+  }
+  return (2ul << (LATENCY_HISTOGRAM_BUCKETS - 1)) - 1;
+}
+
+int LatencyTracer::writeSummary (char* buffer, int maxLength) {
+  const char* stageNames[LATENCY_STAGE_COUNT] = {"rx", "ack", "cmd", "reply", "total"};
+  int pos = snprintf(buffer, maxLength, "Latency ms p50/90/99");
+  for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT && pos < maxLength; stage++) {
+    pos += snprintf(buffer + pos, maxLength - pos, " %s:%lu/%lu/%lu",
+      stageNames[stage],
+      (getPercentile((LatencyStage)stage, 50) + 999) / 1000,
+      (getPercentile((LatencyStage)stage, 90) + 999) / 1000,
+      (getPercentile((LatencyStage)stage, 99) + 999) / 1000);
+  }
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,67 @@
+#include "../tasks/TaskPlatform.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#define LATENCY_TRACE_RING_SIZE 16 // messages that can be in flight at once
+#define LATENCY_HISTOGRAM_BUCKETS 24 // log2 micros, last bucket is ~8 sec and up
+#define LATENCY_TRACE_NONE 0
+
+enum LatencyStage {
+  LatencyStageRetrieve = 0, // hasMessage -> retrieveMessage done
+  LatencyStageAck = 1, // retrieved -> ack sent
+  LatencyStageExecute = 2, // retrieved -> remote command executed
+  LatencyStageReply = 3, // executed -> reply left the outbound queue
+  LatencyStageTotal = 4 // hasMessage -> last thing done for the message
+};
+
+#define LATENCY_STAGE_COUNT 5
+
+/**
+ * Follows each inbound message through receive, ack, command execution and
+ * reply, and keeps a log2 histogram of how long each stage took. Traces are
+ * identified by a sequence number, so a stale id (ring slot reused) is ignored.
+ */
+class LatencyTracer {
+  public:
+    LatencyTracer ();
+
+    uint16_t begin (unsigned long detectedMicros);
+    void retrieved (uint16_t traceId);
+    void expect (uint16_t traceId); // an ack or reply will finish this trace later
+    void ackSent (uint16_t traceId);
+    void executed (uint16_t traceId);
+    void replySent (uint16_t traceId);
+    void release (uint16_t traceId); // dispatch is done with the message
+    void discard (uint16_t traceId); // nothing usable was retrieved
+
+    unsigned long getPercentile (LatencyStage stage, uint8_t percentile); // upper bound, micros
+    unsigned long getCount (LatencyStage stage) { return counts[stage]; }
+
+    // formats p50/p90/p99 (ms) for every stage
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    struct LatencyTrace {
+      uint16_t seq;
+      uint8_t outstanding;
+      unsigned long detected;
+      unsigned long retrieved;
+      unsigned long executed;
+      unsigned long lastEvent;
+    };
+
+    LatencyTrace traces[LATENCY_TRACE_RING_SIZE];
+    uint16_t nextSeq = 1;
+
+    uint32_t histograms[LATENCY_STAGE_COUNT][LATENCY_HISTOGRAM_BUCKETS];
+    unsigned long counts[LATENCY_STAGE_COUNT];
+
+    LatencyTrace* find (uint16_t traceId);
+    void record (LatencyStage stage, unsigned long elapsedMicros);
+    void finishEvent (LatencyTrace* trace, unsigned long now);
+};
+
+#endif
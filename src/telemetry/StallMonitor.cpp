@@ -0,0 +1,90 @@
+#include "StallMonitor.h"
+
+StallMonitor::StallMonitor () {
+  memset(phaseStart, 0, sizeof(phaseStart));
+  memset(iterationPhaseMicros, 0, sizeof(iterationPhaseMicros));
+  memset(phaseStats, 0, sizeof(phaseStats));
+}
+
+void StallMonitor::beginIteration () {
+  memset(iterationPhaseMicros, 0, sizeof(iterationPhaseMicros));
+  iterationStart = TaskPlatform::nowMicros();
+}
+
+void StallMonitor::enter (StallPhase phase) {
+  phaseStart[phase] = TaskPlatform::nowMicros();
+}
+
+void StallMonitor::exit (StallPhase phase) {
+  unsigned long elapsed = TaskPlatform::nowMicros() - phaseStart[phase];
+  iterationPhaseMicros[phase] += elapsed;
+  if (elapsed > phaseStats[phase].worstMicros) {
+    phaseStats[phase].worstMicros = elapsed;
+  }
+}
+
+void StallMonitor::endIteration () {
+  unsigned long elapsed = TaskPlatform::nowMicros() - iterationStart;
+  iterations++;
+  if (elapsed > worstIterationMicros) {
+    worstIterationMicros = elapsed;
+  }
+
+  if (elapsed <= budgetMicros) {
+    return;
+  }
+
+  // blame the phase that took the most, time outside any phase is other
+  unsigned long attributed = 0;
+  StallPhase offender = StallPhaseOther;
+  for (uint8_t phase = 0; phase < StallPhaseOther; phase++) {
+    attributed += iterationPhaseMicros[phase];
+    if (iterationPhaseMicros[phase] > iterationPhaseMicros[offender]) {
+      offender = (StallPhase)phase;
+    }
+  }
+  unsigned long unattributed = elapsed > attributed ? elapsed - attributed : 0;
+  if (unattributed > iterationPhaseMicros[offender]) {
+    offender = StallPhaseOther;
+    iterationPhaseMicros[StallPhaseOther] = unattributed;
+    if (unattributed > phaseStats[StallPhaseOther].worstMicros) {
+      phaseStats[StallPhaseOther].worstMicros = unattributed;
+    }
+  }
+
+  stallCount++;
+  phaseStats[offender].stalls++;
+  lastStallPhase = offender;
+  lastStallMicros = elapsed;
+  lastStallPhaseMicros = iterationPhaseMicros[offender];
+  stallPending = true;
+}
+
+bool StallMonitor::takeStall (StallPhase& phase, unsigned long& iterationMicros, unsigned long& phaseMicros) {
+  if (!stallPending) {
+    return false;
+  }
+
+  phase = lastStallPhase;
+  iterationMicros = lastStallMicros;
+  phaseMicros = lastStallPhaseMicros;
+  stallPending = false;
+  return true;
+}
+
+const char* StallMonitor::getPhaseName (StallPhase phase) {
+  const char* phaseNames[STALL_PHASE_COUNT] = {"flush", "rx", "mesh", "prune", "display", "gps", "send", "lock", "other"};
+  return phaseNames[phase];
+}
+
+int StallMonitor::writeSummary (char* buffer, int maxLength) {
+  int pos = snprintf(buffer, maxLength, "%lu/%lu >%lums, worst %lums",
+    stallCount, iterations, getBudget(), worstIterationMicros / 1000);
+  for (uint8_t phase = 0; phase < STALL_PHASE_COUNT && pos < maxLength; phase++) {
+    if (phaseStats[phase].stalls > 0) {
+      pos += snprintf(buffer + pos, maxLength - pos, " %s:%lu/%lums",
+        getPhaseName((StallPhase)phase), phaseStats[phase].stalls, phaseStats[phase].worstMicros / 1000);
+    }
+  }
+  return pos < maxLength ? pos : maxLength - 1;
+}
@@ -0,0 +1,89 @@
+#include "../tasks/TaskPlatform.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifndef STALLMONITOR_H
+#define STALLMONITOR_H
+
+#define STALL_DEFAULT_BUDGET_MILLIS 500 // an iteration longer than this is a stall
+
+enum StallPhase {
+  StallPhaseFlush = 0, // storage zone writes
+  StallPhaseReceive = 1, // radio reads, including handling what was read
+  StallPhaseMeshSync = 2,
+  StallPhasePrune = 3,
+  StallPhaseDisplay = 4, // title rotation and oled writes
+  StallPhaseGps = 5,
+  StallPhaseSend = 6, // outbound messages and acks
+  StallPhaseLockWait = 7, // waiting on the other task for chatter
+  StallPhaseOther = 8 // whatever the phases above didn't cover
+};
+
+#define STALL_PHASE_COUNT 9
+
+/**
+ * Stands in for the disabled watchdogs. Each loop marks its iteration and
+ * the phases inside it. An iteration over the budget counts as a stall
+ * against whichever phase took the most of it. One monitor per task, since
+ * an iteration can only be timed by the task running it.
+ */
+class StallMonitor {
+  public:
+    StallMonitor ();
+
+    void setBudget (unsigned long budgetMillis) { budgetMicros = budgetMillis * 1000ul; }
+    unsigned long getBudget () { return budgetMicros / 1000ul; }
+
+    void beginIteration ();
+    void endIteration (); // attributes the iteration if it went over budget
+    void enter (StallPhase phase);
+    void exit (StallPhase phase);
+
+    unsigned long getIterationCount () { return iterations; }
+    unsigned long getStallCount () { return stallCount; }
+    unsigned long getStallCount (StallPhase phase) { return phaseStats[phase].stalls; }
+    unsigned long getWorstMicros (StallPhase phase) { return phaseStats[phase].worstMicros; }
+    unsigned long getWorstIterationMicros () { return worstIterationMicros; }
+    static const char* getPhaseName (StallPhase phase);
+
+    // true once for each stall not yet reported, fills in the details
+    bool takeStall (StallPhase& phase, unsigned long& iterationMicros, unsigned long& phaseMicros);
+
+    // counts and worst ms of each phase that has stalled
+    int writeSummary (char* buffer, int maxLength);
+
+  protected:
+    struct PhaseStats {
+      unsigned long stalls; // iterations this phase was blamed for
+      unsigned long worstMicros; // longest single run of the phase
+    };
+
+    unsigned long budgetMicros = STALL_DEFAULT_BUDGET_MILLIS * 1000ul;
+
+    unsigned long iterationStart = 0;
+    unsigned long phaseStart[STALL_PHASE_COUNT];
+    unsigned long iterationPhaseMicros[STALL_PHASE_COUNT];
+
+    PhaseStats phaseStats[STALL_PHASE_COUNT];
+    unsigned long iterations = 0;
+    unsigned long stallCount = 0;
+    unsigned long worstIterationMicros = 0;
+
+    // the latest stall, waiting to be logged
+    volatile bool stallPending = false;
+    StallPhase lastStallPhase = StallPhaseOther;
+    unsigned long lastStallMicros = 0;
+    unsigned long lastStallPhaseMicros = 0;
+};
+
+// marks an iteration for the life of the guard
+class StallIteration {
+  public:
+    StallIteration (StallMonitor* _monitor) { monitor = _monitor; monitor->beginIteration(); }
+    ~StallIteration () { monitor->endIteration(); }
+
+  protected:
+    StallMonitor* monitor;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <string.h>
+#include "../../src/display/FrameCompositor.h"
+
+#ifndef FAKEDISPLAY_H
+#define FAKEDISPLAY_H
+
+#define FAKE_LINE_HEIGHT 16 // DISPLAY_LINE_HEIGHT
+#define FAKE_TEXT_TOP 12 // DISPLAY_TEXT_TOP
+#define FAKE_GLYPH_WIDTH 6 // a 10 pt font averages about this
+#define FAKE_PAGE_COMMAND_BYTES 3 // sh1106 page address, column low, column high before each run
+#define FAKE_I2C_NANOS_PER_BYTE 22500 // 400 kHz, 9 clocks a byte with the ack
+
+/**
+ * Host stand-ins for the oled library and the panel: a font that sets
+ * glyphs pixel by pixel, and a sink that counts what would go over I2C
+ * and how long that takes. Shared by the display benchmarks.
+ */
+inline uint16_t fakeStringWidth (const char* text) {
+  uint16_t width = 0;
+  for (const char* c = text; *c != 0; c++) {
+    width += (*c == ' ' || *c == '.') ? 3 : FAKE_GLYPH_WIDTH;
+  }
+  return width;
+}
+
+inline void fakeSetPixel (uint8_t* frame, int16_t x, int16_t y) {
+  if (x >= 0 && x < FRAME_WIDTH && y >= 0 && y < FRAME_HEIGHT) {
+    frame[(y >> 3) * FRAME_WIDTH + x] |= 1 << (y & 7);
+  }
+}
+
+inline void fakeDrawString (uint8_t* frame, int16_t x0, int16_t y0, const char* text) {
+  int16_t x = x0;
+  for (const char* c = text; *c != 0; c++) {
+    uint8_t glyphWidth = (*c == ' ' || *c == '.') ? 3 : FAKE_GLYPH_WIDTH;
+    for (uint8_t column = 0; column + 1 < glyphWidth; column++) {
+      // some made up glyph bits, one pixel at a time like the real font renderer
+      uint16_t bits = (uint16_t)((*c * 2654435761u) >> (column * 3)) & 0x1ffe;
+      for (uint8_t row = 0; row < 13; row++) {
+        if (bits & (1 << row)) {
+          fakeSetPixel(frame, x + column, y0 + row);
+        }
+      }
+    }
+    x += glyphWidth;
+  }
+}
+
+inline void fakeClearBand (uint8_t* frame, int16_t y0, int16_t left, int16_t right) {
+  for (int16_t y = y0; y < y0 + FAKE_LINE_HEIGHT && y < FRAME_HEIGHT; y++) {
+    for (int16_t x = left; x < right; x++) {
+      frame[(y >> 3) * FRAME_WIDTH + x] &= ~(1 << (y & 7));
+    }
+  }
+}
+
+// measures and draws a line centered in its band, the way updateDisplay does on a miss
+inline void fakeDrawLine (uint8_t* frame, uint8_t line, const char* text, int16_t left, int16_t right) {
+  int16_t y0 = FAKE_TEXT_TOP + line * FAKE_LINE_HEIGHT;
+  fakeClearBand(frame, y0, left, right);
+  fakeDrawString(frame, (FRAME_WIDTH - fakeStringWidth(text)) / 2, y0, text);
+}
+
+class FakeBusSink : public FrameSink {
+  public:
+    unsigned long busBytes = 0;
+    unsigned long pageWrites = 0;
+
+    uint16_t writePage (uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) {
+      (void)page;
+      (void)column;
+      (void)data;
+      pageWrites++;
+      busBytes += FAKE_PAGE_COMMAND_BYTES + length;
+      return length;
+    }
+
+    // the whole frame, what display->display() sends
+    void writeFrame () {
+      pageWrites += FRAME_PAGES;
+      busBytes += FRAME_PAGES * (FAKE_PAGE_COMMAND_BYTES + FRAME_WIDTH);
+    }
+
+    unsigned long getBusMicros () { return (unsigned long)((unsigned long long)busBytes * FAKE_I2C_NANOS_PER_BYTE / 1000ull); }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include "../../src/control/FlushScheduler.h"
+
+#define BENCH_ZONES 8
+#define BENCH_RUN_MILLIS 3600000ul // an hour of control loop
+#define BENCH_SESSION_MICROS 15000ul // mount and open, paid once per session
+#define BENCH_FAILING_ZONE 4
+
+// zone flush delays and what one write of each zone costs on the card
+static const unsigned long zoneDelayMillis[BENCH_ZONES] = {20000, 120000, 60000, 90000, 300000, 70000, 30000, 30000};
+static const unsigned long zoneWriteMicros[BENCH_ZONES] = {40000, 120000, 80000, 20000, 150000, 30000, 10000, 10000};
+
+static unsigned long fakeMicros = 0;
+static unsigned long fakeClock () { return fakeMicros; }
+
+static uint32_t benchSeed = 1;
+static uint32_t benchRandom () {
+  benchSeed = benchSeed * 1103515245u + 12345u;
+  return benchSeed >> 16;
+}
+
+// stands in for the sd card, every call just moves the fake clock
+class FakeBackend : public FlushBackend {
+  public:
+    bool dirty[BENCH_ZONES] = {};
+    unsigned long opens = 0;
+    unsigned long failures = 0;
+    uint8_t failingZone = FLUSH_MAX_ZONES; // none
+    unsigned long failUntilMillis = 0;
+    unsigned long lastWrittenMillis[BENCH_ZONES] = {};
+
+    bool isZoneDirty (uint8_t zone) { return dirty[zone]; }
+    bool openFlushSession () { opens++; fakeMicros += BENCH_SESSION_MICROS; return true; }
+    bool flushZone (uint8_t zone) {
+      fakeMicros += zoneWriteMicros[zone];
+      if (zone == failingZone && fakeMicros / 1000ul < failUntilMillis) {
+        failures++;
+        return false;
+      }
+      dirty[zone] = false;
+      lastWrittenMillis[zone] = fakeMicros / 1000ul;
+      return true;
+    }
+    void closeFlushSession () {}
+};
+
+struct BenchResult {
+  unsigned long flushes;
+  unsigned long sessions;
+  unsigned long avgLateMillis;
+  unsigned long worstLateMillis;
+  unsigned long busyMillis;
+};
+
+// one session per overdue zone, started from a random zone: the flush before the scheduler
+static bool flushRandom (FlushScheduler* scheduler, FakeBackend* backend, unsigned long now) {
+  uint8_t zone = benchRandom() % BENCH_ZONES;
+  for (uint8_t i = 0; i < BENCH_ZONES; i++, zone = (zone + 1) % BENCH_ZONES) {
+    if (!scheduler->isScheduled(zone) || (long)(now - scheduler->getDeadline(zone)) < 0) {
+      continue;
+    }
+    if (!backend->isZoneDirty(zone)) {
+      scheduler->clear(zone);
+      continue;
+    }
+    backend->openFlushSession();
+    unsigned long writeStart = fakeMicros;
+    if (backend->flushZone(zone)) {
+      scheduler->recordFlush(zone, now, fakeMicros - writeStart);
+    }
+    else {
+      scheduler->reschedule(zone, now);
+    }
+    return true;
+  }
+  return false;
+}
+
+static BenchResult runBench (unsigned long periodMillis, bool earliestDeadline, FakeBackend* backend) {
+  FlushScheduler scheduler(BENCH_ZONES, fakeClock);
+  for (uint8_t zone = 0; zone < BENCH_ZONES; zone++) {
+    scheduler.setDelay(zone, zoneDelayMillis[zone]);
+  }
+
+  benchSeed = 1;
+  unsigned long busyMicros = 0;
+  for (unsigned long now = 0; now < BENCH_RUN_MILLIS; now += periodMillis) {
+    fakeMicros = now * 1000ul;
+
+    // now and then a burst of messages dirties a handful of zones
+    if (benchRandom() % 5 == 0) {
+      for (uint8_t zone = 0; zone < BENCH_ZONES; zone++) {
+        if (benchRandom() % 2) {
+          backend->dirty[zone] = true;
+        }
+      }
+    }
+    for (uint8_t zone = 0; zone < BENCH_ZONES; zone++) {
+      if (backend->dirty[zone]) {
+        scheduler.schedule(zone, now);
+      }
+    }
+
+    unsigned long before = fakeMicros;
+    if (earliestDeadline) {
+      scheduler.flushDue(backend, now);
+    }
+    else {
+      flushRandom(&scheduler, backend, now);
+    }
+    busyMicros += fakeMicros - before;
+  }
+
+  BenchResult result = {};
+  unsigned long totalLate = 0;
+  for (uint8_t zone = 0; zone < BENCH_ZONES; zone++) {
+    FlushZoneStats* stats = scheduler.getZoneStats(zone);
+    result.flushes += stats->flushes;
+    totalLate += stats->totalLatenessMillis;
+    if (stats->worstLatenessMillis > result.worstLateMillis) {
+      result.worstLateMillis = stats->worstLatenessMillis;
+    }
+  }
+  result.avgLateMillis = result.flushes > 0 ? totalLate / result.flushes : 0;
+  result.sessions = backend->opens;
+  result.busyMillis = busyMicros / 1000ul;
+  return result;
+}
+
+static void printResult (const char* name, unsigned long periodMillis, BenchResult* result) {
+  printf("period %4lu ms %-6s: flushes %6lu, sessions %6lu, late avg %6lu ms, worst %7lu ms, sd busy %7lu ms\n",
+    periodMillis, name, result->flushes, result->sessions, result->avgLateMillis, result->worstLateMillis, result->busyMillis);
+}
+
+int main () {
+  bool passed = true;
+  const unsigned long periods[] = {50, 500};
+
+  for (unsigned long periodMillis : periods) {
+    FakeBackend randomBackend;
+    BenchResult random = runBench(periodMillis, false, &randomBackend);
+    FakeBackend edfBackend;
+    BenchResult edf = runBench(periodMillis, true, &edfBackend);
+
+    printResult("random", periodMillis, &random);
+    printResult("edf", periodMillis, &edf);
+    if (edf.sessions > random.sessions || edf.avgLateMillis > random.avgLateMillis) {
+      printf("  edf should open fewer sessions and run less late on average than one zone at a time\n");
+      passed = false;
+    }
+  }
+
+  // a zone whose writes fail for the first ten minutes keeps its deadline and is written once the card recovers
+  FakeBackend failingBackend;
+  failingBackend.failingZone = BENCH_FAILING_ZONE;
+  failingBackend.failUntilMillis = 600000ul;
+  BenchResult failing = runBench(50, true, &failingBackend);
+  printResult("failing", 50ul, &failing);
+  unsigned long lastWritten = failingBackend.lastWrittenMillis[BENCH_FAILING_ZONE];
+  printf("  zone %d failed %lu writes, last written at %lu ms\n", BENCH_FAILING_ZONE, failingBackend.failures, lastWritten);
+  if (failingBackend.failures == 0 || lastWritten < failingBackend.failUntilMillis) {
+    printf("  the failing zone was never retried after the card recovered\n");
+    passed = false;
+  }
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include "../../src/display/FrameCompositor.h"
+
+static bool passed = true;
+static void expect (bool condition, const char* what) {
+  if (!condition) {
+    printf("FAILED: %s\n", what);
+    passed = false;
+  }
+}
+
+// a run of lit columns within one page, like a line of text would leave
+static void drawSpan (uint8_t* frame, uint8_t page, uint8_t firstColumn, uint8_t length, uint8_t pattern) {
+  memset(&frame[page * FRAME_WIDTH + firstColumn], pattern, length);
+}
+
+static unsigned long totalPageWrites (RecordingFrameSink* sink) {
+  unsigned long total = 0;
+  for (uint8_t page = 0; page < FRAME_PAGES; page++) {
+    total += sink->getPageWrites(page);
+  }
+  return total;
+}
+
+int main () {
+  RecordingFrameSink sink;
+  FrameCompositor compositor(&sink);
+  uint8_t frame[FRAME_BUFFER_SIZE];
+  memset(frame, 0, sizeof(frame));
+
+  // first frame: a title on pages 0-1 and a status line on pages 4-5
+  drawSpan(frame, 0, 10, 100, 0x7e);
+  drawSpan(frame, 1, 10, 100, 0x3c);
+  drawSpan(frame, 4, 20, 60, 0x55);
+  drawSpan(frame, 5, 20, 60, 0xaa);
+  expect(compositor.isFrameDue(0), "the first frame is always due");
+  expect(compositor.flush(frame, 0) == 4, "only the four drawn pages go out over a cleared panel");
+  expect(sink.matches(frame), "the panel shows the first frame");
+  expect(sink.getPageWrites(2) == 0 && sink.getPageWrites(7) == 0, "blank pages aren't written");
+  expect(compositor.getLastFrameBytes() == 320, "each page sends just its changed span");
+
+  // second frame: only the status text changes, in the middle of page 5
+  expect(!compositor.isFrameDue(FRAME_MIN_INTERVAL - 1), "no new frame inside FRAME_MIN_INTERVAL");
+  expect(compositor.getMillisUntilDue(FRAME_MIN_INTERVAL - 1) == 1, "and it says how long to wait");
+  drawSpan(frame, 5, 40, 8, 0xff);
+  unsigned long writesBefore = totalPageWrites(&sink);
+  expect(compositor.flush(frame, FRAME_MIN_INTERVAL) == 1, "one changed page, one page write");
+  expect(totalPageWrites(&sink) == writesBefore + 1 && sink.getPageWrites(5) == 2, "and it's page 5");
+  expect(compositor.getLastFrameBytes() == 8, "only the 8 changed columns are sent");
+  expect(sink.matches(frame), "the panel shows the second frame");
+
+  // nothing changed, nothing sent
+  expect(compositor.flush(frame, FRAME_MIN_INTERVAL * 2) == 0 && compositor.getLastFrameBytes() == 0, "an unchanged frame writes nothing");
+
+  // after the panel is cleared or powered off, everything goes out again
+  compositor.invalidate();
+  expect(compositor.flush(frame, FRAME_MIN_INTERVAL * 3) == FRAME_PAGES, "an invalidated panel gets every page");
+  expect(compositor.getLastFrameBytes() == FRAME_BUFFER_SIZE, "in full");
+
+  char summary[128];
+  compositor.writeSummary(summary, sizeof(summary));
+  printf("%s\nframe compositor: %s\n", summary, passed ? "ok" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "../../src/tasks/IdleScheduler.h"
+
+#define TRACE_MILLIS 600000ul // ten minutes of traffic
+#define TRACE_MAX_ARRIVALS 20000
+
+static unsigned long arrivals[TRACE_MAX_ARRIVALS];
+
+// evenly spaced messages, one every periodMillis
+static uint16_t buildTrace (unsigned long periodMillis) {
+  uint16_t count = 0;
+  for (unsigned long at = periodMillis; at < TRACE_MILLIS && count < TRACE_MAX_ARRIVALS; at += periodMillis) {
+    arrivals[count++] = at;
+  }
+  return count;
+}
+
+// replays the trace and checks the projected savings land in [minSavings, maxSavings]
+static bool checkTrace (const char* name, unsigned long periodMillis, bool lightSleep, uint8_t minSavings, uint8_t maxSavings) {
+  IdleScheduler scheduler;
+  uint16_t count = buildTrace(periodMillis);
+  scheduler.simulateTrace(arrivals, count, TRACE_MILLIS, lightSleep);
+
+  char summary[128];
+  scheduler.writeSummary(summary, sizeof(summary));
+  uint8_t savings = scheduler.getProjectedSavingsPercent();
+  bool passed = savings >= minSavings && savings <= maxSavings;
+  printf("%-7s every %5lu ms %-7s: %s%s\n", name, periodMillis, lightSleep ? "sleep" : "blocked", summary, passed ? "" : "  <- out of range");
+  return passed;
+}
+
+int main () {
+  bool passed = true;
+
+  // a quiet mesh spends nearly all its time idle, light sleep draws ~2mA against 50mA running
+  passed &= checkTrace("quiet", 30000, true, 90, 96);
+  passed &= checkTrace("quiet", 30000, false, 55, 60);
+
+  // a message every second still leaves most of each second idle
+  passed &= checkTrace("steady", 1000, true, 85, 96);
+
+  // arrivals closer than a cycle plus IDLE_MIN_WINDOW only idle once the trace runs out
+  passed &= checkTrace("busy", 50, true, 0, 2);
+
+  // sleeping can never cost more than blocking for the same traffic
+  IdleScheduler sleeping;
+  IdleScheduler blocked;
+  uint16_t count = buildTrace(200);
+  sleeping.simulateTrace(arrivals, count, TRACE_MILLIS, true);
+  blocked.simulateTrace(arrivals, count, TRACE_MILLIS, false);
+  if (sleeping.getAverageMilliamps() > blocked.getAverageMilliamps() || sleeping.getActivePercent() != blocked.getActivePercent()) {
+    printf("light sleep should only change the idle draw, not the duty cycle\n");
+    passed = false;
+  }
+
+  return passed ? 0 : 1;
+}
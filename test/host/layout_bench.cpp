@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include "../../src/display/LineLayoutCache.h"
+#include "../../src/tasks/TaskPlatform.h"
+#include "FakeDisplay.h"
+
+#define BENCH_REDRAWS 200000ul
+
+// what updateDisplay does with a line that changed
+static void drawLine (LineLayoutCache* cache, uint8_t* frame, uint8_t line, const char* text) {
+  int16_t y0 = FAKE_TEXT_TOP + line * FAKE_LINE_HEIGHT;
+  if (cache != nullptr) {
+    LineLayout* layout = cache->find(line, text);
+    if (layout != nullptr) {
+      cache->render(layout, frame);
+      return;
+    }
+  }
+
+  fakeDrawLine(frame, line, text, LAYOUT_BAND_LEFT, LAYOUT_BAND_RIGHT);
+  if (cache != nullptr) {
+    uint16_t width = fakeStringWidth(text);
+    cache->store(line, text, (FRAME_WIDTH - width) / 2, y0, width, frame);
+  }
+}
+
+// the receive statuses processOneCycle shows, as they'd land on frames under traffic
+static const char* statuses[] = {"Listening", "Ready", "Listening", "Receiving", "Ready", "Mesh", "Ready", "Listening"};
+static const char* dashboard[] = {"Nearby: 3", "Nearby: 4", "Msgs: 12", "Nearby: 3"};
+
+// the title rotates between the alias and the time, and the time is new every minute
+static void titleText (unsigned long rotation, char* text) {
+  if (rotation % 2 == 0) {
+    sprintf(text, "b.48213 @ temp");
+  }
+  else {
+    sprintf(text, "%lu:%02lu PM", 1 + (rotation / 24) % 12, (rotation / 2) % 60);
+  }
+}
+
+static unsigned long runBench (LineLayoutCache* cache, uint8_t* frame) {
+  unsigned long start = TaskPlatform::nowMicros();
+  for (unsigned long i = 0; i < BENCH_REDRAWS; i++) {
+    // the status changes every redraw, the title every 8th, the dashboard every 32nd
+    drawLine(cache, frame, 2, statuses[i % 8]);
+    if (i % 8 == 0) {
+      char title[LAYOUT_TEXT_MAX];
+      titleText(i / 8, title);
+      drawLine(cache, frame, 0, title);
+    }
+    if (i % 32 == 0) {
+      drawLine(cache, frame, 1, dashboard[(i / 32) % 4]);
+    }
+  }
+  return TaskPlatform::nowMicros() - start;
+}
+
+int main () {
+  static uint8_t drawnFrame[FRAME_BUFFER_SIZE];
+  static uint8_t cachedFrame[FRAME_BUFFER_SIZE];
+  static LineLayoutCache cache;
+
+  unsigned long drawnMicros = runBench(nullptr, drawnFrame);
+  unsigned long cachedMicros = runBench(&cache, cachedFrame);
+
+  // the same lines go through both runs
+  unsigned long lookups = cache.getHitCount() + cache.getMissCount();
+  printf("%lu redraws: measured and drawn %lu ns/line, cached %lu ns/line, %lu%% hits\n",
+    BENCH_REDRAWS, drawnMicros * 1000ul / lookups, cachedMicros * 1000ul / lookups, cache.getHitCount() * 100 / lookups);
+  printf("cache RAM: %lu B a string, %lu B for %d lines x %d\n",
+    (unsigned long)sizeof(LineLayout), (unsigned long)sizeof(LineLayoutCache), LAYOUT_CACHE_LINES, LAYOUT_CACHE_WAYS);
+
+  // the cached lines have to come out exactly as drawing them again would
+  bool passed = memcmp(drawnFrame, cachedFrame, FRAME_BUFFER_SIZE) == 0;
+  if (!passed) {
+    printf("cached frame differs from the drawn one\n");
+  }
+  // only the new times should miss, one every other title rotation
+  unsigned long expectedMisses = BENCH_REDRAWS / 16 + LAYOUT_CACHE_LINES * LAYOUT_CACHE_WAYS;
+  if (cache.getMissCount() > expectedMisses) {
+    printf("the statuses and dashboard should fit the cache, %lu misses\n", cache.getMissCount());
+    passed = false;
+  }
+  return passed ? 0 : 1;
+}
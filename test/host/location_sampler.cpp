@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include "../../src/control/LocationSampler.h"
+
+#define METERS_PER_DEGREE 111195.0 // latitude, LOCATION_EARTH_RADIUS * pi / 180
+
+static bool passed = true;
+static void expect (bool condition, const char* what) {
+  if (!condition) {
+    printf("FAILED: %s\n", what);
+    passed = false;
+  }
+}
+
+static LocationFix makeFix (double northMeters, float heading, float speed, unsigned long sampledAt) {
+  LocationFix fix;
+  memset(&fix, 0, sizeof(fix));
+  fix.gnssEnabled = true;
+  fix.valid = true;
+  fix.latitude = 42.36 + northMeters / METERS_PER_DEGREE;
+  fix.longitude = -71.06;
+  fix.heading = heading;
+  fix.speed = speed;
+  fix.sampledAt = sampledAt;
+  return fix;
+}
+
+// publishes and stores the fix like refreshGpsCoords does, returns whether it was stored
+static bool sample (LocationSampler* sampler, const LocationFix& fix) {
+  if (sampler->publish(fix)) {
+    sampler->markStored(fix);
+    return true;
+  }
+  return false;
+}
+
+int main () {
+  LocationSampler sampler;
+
+  LocationFix noFix = makeFix(0, 0, 0, 0);
+  noFix.valid = false;
+  expect(!sample(&sampler, noFix), "no fix, nothing stored");
+  expect(sampler.getSampleCount() == 1 && !sampler.getLatest().valid, "but the snapshot still says so");
+
+  expect(sample(&sampler, makeFix(0, 0, 0, 1000)), "the first valid fix is always stored");
+
+  // distance
+  expect(!sample(&sampler, makeFix(LOCATION_STORE_MIN_METERS - 2, 0, 0, 2000)), "jitter under the distance threshold isn't stored");
+  expect(sample(&sampler, makeFix(LOCATION_STORE_MIN_METERS + 1, 0, 0, 3000)), "moving past it is");
+  expect(sampler.getLatest().sampledAt == 3000, "the snapshot always has the latest fix");
+
+  // heading, only counted while moving
+  float base = LOCATION_STORE_MIN_METERS + 1;
+  expect(!sample(&sampler, makeFix(base, 90, LOCATION_STORE_MIN_SPEED / 2, 4000)), "a turn while standing still is noise");
+  expect(!sample(&sampler, makeFix(base, LOCATION_STORE_MIN_HEADING - 5, LOCATION_STORE_MIN_SPEED * 2, 5000)), "a small turn while moving isn't stored");
+  expect(sample(&sampler, makeFix(base, LOCATION_STORE_MIN_HEADING + 5, LOCATION_STORE_MIN_SPEED * 2, 6000)), "a real turn while moving is");
+  expect(LocationSampler::headingDelta(350, 10) == 20, "heading wraps through north");
+
+  // age
+  LocationFix stored = sampler.getLatest();
+  expect(!sample(&sampler, makeFix(base, stored.heading, 0, stored.sampledAt + LOCATION_STORE_MAX_AGE - 1)), "a parked fix waits out LOCATION_STORE_MAX_AGE");
+  expect(sample(&sampler, makeFix(base, stored.heading, 0, stored.sampledAt + LOCATION_STORE_MAX_AGE)), "then it's stored again");
+
+  // a parked node sampled once a second for an hour, with a few meters of gps wander
+  LocationSampler parked;
+  for (unsigned long second = 0; second < 3600; second++) {
+    sample(&parked, makeFix((second % 7) * 1.5, (float)(second * 37 % 360), 0.2f, second * 1000));
+  }
+  printf("parked hour: %lu samples, %lu stored\n", parked.getSampleCount(), parked.getStoreCount());
+  expect(parked.getStoreCount() == 3600000ul / LOCATION_STORE_MAX_AGE, "a parked node only stores on age");
+
+  // walking north at 1.4 m/s for ten minutes
+  LocationSampler walking;
+  for (unsigned long second = 0; second < 600; second++) {
+    sample(&walking, makeFix(second * 1.4, 0, 1.4f, second * 1000));
+  }
+  printf("walking 10 min: %lu samples, %lu stored\n", walking.getSampleCount(), walking.getStoreCount());
+  expect(walking.getStoreCount() >= 600 * 1.4 / (LOCATION_STORE_MIN_METERS + 2) && walking.getStoreCount() <= 600 * 1.4 / LOCATION_STORE_MIN_METERS + 1, "walking stores about once per LOCATION_STORE_MIN_METERS");
+
+  printf("location sampler: %s\n", passed ? "ok" : "FAILED");
+  return passed ? 0 : 1;
+}
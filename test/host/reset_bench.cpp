@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../../src/tasks/TaskPlatform.h"
+
+// same layout and step size as ControlMode: 12 zone folders, STORAGE_TRASH_STEP_ENTRIES per step
+#define BENCH_ZONE_FOLDERS 12
+#define BENCH_TRASH_STEP_ENTRIES 8
+#define BENCH_FILE_BYTES 100
+#define BENCH_PATH_SIZE 256
+
+static char benchRoot[BENCH_PATH_SIZE];
+static char storageRoot[BENCH_PATH_SIZE];
+static char trashRoot[BENCH_PATH_SIZE];
+
+static void buildStorage (int filesPerZone) {
+  char path[BENCH_PATH_SIZE];
+  char contents[BENCH_FILE_BYTES];
+  memset(contents, 'x', sizeof(contents));
+
+  mkdir(storageRoot, 0755);
+  for (int zone = 0; zone < BENCH_ZONE_FOLDERS; zone++) {
+    snprintf(path, sizeof(path), "%s/%d", storageRoot, zone);
+    mkdir(path, 0755);
+    for (int i = 0; i < filesPerZone; i++) {
+      snprintf(path, sizeof(path), "%s/%d/%08x", storageRoot, zone, i);
+      FILE* file = fopen(path, "w");
+      fwrite(contents, 1, sizeof(contents), file);
+      fclose(file);
+    }
+  }
+
+  // the device store and key files at the top of the tree
+  snprintf(path, sizeof(path), "%s/keys", storageRoot);
+  FILE* file = fopen(path, "w");
+  fwrite(contents, 1, sizeof(contents), file);
+  fclose(file);
+}
+
+// wipeStorage: every file of every zone folder, then the folders
+static int wipeStorage () {
+  char folder[BENCH_PATH_SIZE];
+  char path[BENCH_PATH_SIZE * 2];
+  int removed = 0;
+  for (int zone = 0; zone < BENCH_ZONE_FOLDERS; zone++) {
+    snprintf(folder, sizeof(folder), "%s/%d", storageRoot, zone);
+    DIR* dir = opendir(folder);
+    if (dir == nullptr) {
+      continue;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      if (entry->d_name[0] == '.') {
+        continue;
+      }
+      snprintf(path, sizeof(path), "%s/%s", folder, entry->d_name);
+      if (unlink(path) == 0) {
+        removed++;
+      }
+    }
+    closedir(dir);
+    rmdir(folder);
+  }
+  snprintf(path, sizeof(path), "%s/keys", storageRoot);
+  unlink(path);
+  rmdir(storageRoot);
+  return removed;
+}
+
+// scrubStorageRoot and the rename, what the fast reset does before restarting
+static void moveStorageToTrash () {
+  char path[BENCH_PATH_SIZE];
+  snprintf(path, sizeof(path), "%s/keys", storageRoot);
+  FILE* file = fopen(path, "r+");
+  char zeros[BENCH_FILE_BYTES] = {};
+  fwrite(zeros, 1, sizeof(zeros), file);
+  fclose(file);
+  truncate(path, 0);
+
+  mkdir(trashRoot, 0755);
+  snprintf(path, sizeof(path), "%s/0", trashRoot);
+  rename(storageRoot, path);
+}
+
+// removeTree: depth first, each file or folder removed costs one from the budget
+static bool removeTree (const char* path, int& budget, int& removed) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    return true;
+  }
+  if (!S_ISDIR(info.st_mode)) {
+    if (budget == 0) {
+      return false;
+    }
+    unlink(path);
+    budget--;
+    removed++;
+    return true;
+  }
+
+  char childPath[BENCH_PATH_SIZE];
+  DIR* dir = opendir(path);
+  while (budget > 0) {
+    struct dirent* child = readdir(dir);
+    while (child != nullptr && child->d_name[0] == '.') {
+      child = readdir(dir);
+    }
+    if (child == nullptr) {
+      closedir(dir);
+      rmdir(path);
+      budget--;
+      removed++;
+      return true;
+    }
+    snprintf(childPath, sizeof(childPath), "%s/%s", path, child->d_name);
+    removeTree(childPath, budget, removed);
+  }
+  closedir(dir);
+  return false;
+}
+
+int main () {
+  snprintf(benchRoot, sizeof(benchRoot), "/tmp/reset_benchXXXXXX");
+  if (mkdtemp(benchRoot) == nullptr) {
+    printf("no temp folder for the bench\n");
+    return 1;
+  }
+  snprintf(storageRoot, sizeof(storageRoot), "%s/chatter", benchRoot);
+  snprintf(trashRoot, sizeof(trashRoot), "%s/trash", benchRoot);
+
+  bool passed = true;
+  const int zoneSizes[] = {20, 200};
+  for (int filesPerZone : zoneSizes) {
+    int expected = filesPerZone * BENCH_ZONE_FOLDERS;
+
+    buildStorage(filesPerZone);
+    unsigned long start = TaskPlatform::nowMicros();
+    int wiped = wipeStorage();
+    unsigned long wipeMicros = TaskPlatform::nowMicros() - start;
+
+    buildStorage(filesPerZone);
+    start = TaskPlatform::nowMicros();
+    moveStorageToTrash();
+    unsigned long moveMicros = TaskPlatform::nowMicros() - start;
+
+    // then the background steps after the restart
+    int steps = 0;
+    int removed = 0;
+    unsigned long worstStepMicros = 0;
+    bool emptied = false;
+    while (!emptied && steps < expected * 2) {
+      int budget = BENCH_TRASH_STEP_ENTRIES;
+      unsigned long stepStart = TaskPlatform::nowMicros();
+      emptied = removeTree(trashRoot, budget, removed);
+      unsigned long stepMicros = TaskPlatform::nowMicros() - stepStart;
+      if (stepMicros > worstStepMicros) {
+        worstStepMicros = stepMicros;
+      }
+      steps++;
+    }
+
+    printf("%5d files: wipe %6lu us before restart, fast %4lu us before restart + %d steps after (worst %lu us)\n",
+      wiped, wipeMicros, moveMicros, steps, worstStepMicros);
+    if (wiped != expected || !emptied || access(storageRoot, F_OK) == 0) {
+      printf("  expected %d files wiped and the trash emptied\n", expected);
+      passed = false;
+    }
+  }
+
+  rmdir(benchRoot);
+  return passed ? 0 : 1;
+}
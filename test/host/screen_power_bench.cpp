@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include "../../src/display/LineLayoutCache.h"
+#include "../../src/tasks/TaskPlatform.h"
+#include "FakeDisplay.h"
+
+#define BENCH_RUN_MILLIS 3600000ul // an hour
+#define BENCH_TICK_MILLIS 100 // FRAME_MIN_INTERVAL, one refresh chance per tick
+#define BENCH_TITLE_ROTATION 5000 // TITLE_ROTATION_FREQUENCY
+#define BENCH_DASHBOARD_INTERVAL 10000 // neighbors are recounted this often
+#define BENCH_PRESS_INTERVAL 600000ul // someone looks at the node every ten minutes
+#define BENCH_POWER_COMMAND_BYTES 5 // display on/off and the two charge pump bytes, with their control bytes
+#define BENCH_LINES 3
+
+struct ScreenCost {
+  unsigned long frames;
+  unsigned long busBytes;
+  unsigned long busMicros; // modeled
+  unsigned long drawMicros; // measured here
+  unsigned long onMillis;
+};
+
+// the lines the display shows at a given time, what rotateDisplay and updateNeighbors leave
+static void currentLines (unsigned long now, char lines[BENCH_LINES][LAYOUT_TEXT_MAX]) {
+  unsigned long rotation = now / BENCH_TITLE_ROTATION;
+  if (rotation % 2 == 0) {
+    snprintf(lines[0], LAYOUT_TEXT_MAX, "b.48213 @ temp");
+  }
+  else {
+    unsigned long minutes = now / 60000ul;
+    snprintf(lines[0], LAYOUT_TEXT_MAX, "%lu:%02lu PM", 1 + (minutes / 60) % 12, minutes % 60);
+  }
+  snprintf(lines[1], LAYOUT_TEXT_MAX, "Nearby: %lu", 2 + (now / BENCH_DASHBOARD_INTERVAL) % 3);
+  snprintf(lines[2], LAYOUT_TEXT_MAX, "%s", (now / 1000) % 4 == 0 ? "Listening" : "Ready");
+}
+
+// screenTimeout 0 is ScreenTimeoutNever, the display before the power down existed
+static ScreenCost runScreen (unsigned long screenTimeout) {
+  static uint8_t frame[FRAME_BUFFER_SIZE];
+  memset(frame, 0, sizeof(frame));
+  LineLayoutCache layouts;
+  FakeBusSink bus;
+  FrameCompositor compositor(&bus);
+  ScreenCost cost = {};
+
+  char lines[BENCH_LINES][LAYOUT_TEXT_MAX];
+  char shown[BENCH_LINES][LAYOUT_TEXT_MAX];
+  memset(shown, 0, sizeof(shown));
+  bool screenOn = true;
+  unsigned long lastPress = 0;
+
+  for (unsigned long now = 0; now < BENCH_RUN_MILLIS; now += BENCH_TICK_MILLIS) {
+    // applyScreenPower
+    if (now - lastPress >= BENCH_PRESS_INTERVAL) {
+      lastPress = now;
+      if (!screenOn) {
+        screenOn = true;
+        bus.busBytes += BENCH_POWER_COMMAND_BYTES;
+        memset(shown, 0, sizeof(shown));
+        compositor.invalidate();
+      }
+    }
+    if (screenOn && screenTimeout > 0 && now - lastPress >= screenTimeout) {
+      screenOn = false;
+      bus.busBytes += BENCH_POWER_COMMAND_BYTES;
+    }
+    if (!screenOn) {
+      // nothing goes to the panel while it's dark
+      continue;
+    }
+    cost.onMillis += BENCH_TICK_MILLIS;
+
+    // updateDisplay: changed lines are drawn (or copied from the cache), one flush
+    currentLines(now, lines);
+    unsigned long drawStart = TaskPlatform::nowMicros();
+    bool changed = false;
+    for (uint8_t line = 0; line < BENCH_LINES; line++) {
+      if (strcmp(lines[line], shown[line]) == 0) {
+        continue;
+      }
+      changed = true;
+      snprintf(shown[line], LAYOUT_TEXT_MAX, "%s", lines[line]);
+      LineLayout* layout = layouts.find(line, lines[line]);
+      if (layout != nullptr) {
+        layouts.render(layout, frame);
+        continue;
+      }
+      fakeDrawLine(frame, line, lines[line], LAYOUT_BAND_LEFT, LAYOUT_BAND_RIGHT);
+      uint16_t width = fakeStringWidth(lines[line]);
+      layouts.store(line, lines[line], (FRAME_WIDTH - width) / 2, FAKE_TEXT_TOP + line * FAKE_LINE_HEIGHT, width, frame);
+    }
+    if (changed) {
+      compositor.flush(frame, now);
+      cost.frames++;
+    }
+    cost.drawMicros += TaskPlatform::nowMicros() - drawStart;
+  }
+
+  cost.busBytes = bus.busBytes;
+  cost.busMicros = bus.getBusMicros();
+  return cost;
+}
+
+static void printCost (const char* name, ScreenCost* cost) {
+  printf("%-12s: on %3lu%%, %5lu frames, %7lu B i2c, display work %6lu ms an hour (%lu ms i2c, %lu ms drawing)\n",
+    name, cost->onMillis * 100 / BENCH_RUN_MILLIS, cost->frames, cost->busBytes,
+    (cost->busMicros + cost->drawMicros) / 1000, cost->busMicros / 1000, cost->drawMicros / 1000);
+}
+
+int main () {
+  ScreenCost never = runScreen(0);
+  ScreenCost oneMinute = runScreen(60000ul);
+  ScreenCost fiveMinutes = runScreen(5ul * 60000ul);
+  printCost("always on", &never);
+  printCost("1 min off", &oneMinute);
+  printCost("5 min off", &fiveMinutes);
+
+  // with a one minute timeout and a press every ten, the panel is lit about a tenth of the time
+  bool passed = oneMinute.onMillis * 8 < never.onMillis && oneMinute.busBytes * 4 < never.busBytes
+    && fiveMinutes.busBytes < never.busBytes;
+  if (!passed) {
+    printf("the timeout should cut the display work roughly in line with the time the panel is dark\n");
+  }
+  return passed ? 0 : 1;
+}
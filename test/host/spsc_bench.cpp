@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include "../../src/tasks/SpscRing.h"
+
+#define SPSC_BENCH_ITEMS 500000ul // messages pushed through each ring
+#define SPSC_BENCH_CAPACITY 8 // same depth as the display and storage rings
+
+template <uint16_t Bytes>
+struct BenchMessage {
+  uint32_t sequence;
+  uint8_t payload[Bytes - sizeof(uint32_t)];
+};
+
+// the ring with a lock around it, to see what the lock-free one saves
+template <typename T, uint16_t Capacity>
+class LockedRing {
+  public:
+    bool push (const T& item) {
+      TaskLockGuard guard(&lock);
+      if (tail - head >= Capacity) {
+        return false;
+      }
+      items[tail++ & (Capacity - 1)] = item;
+      return true;
+    }
+
+    bool pop (T& item) {
+      TaskLockGuard guard(&lock);
+      if (head == tail) {
+        return false;
+      }
+      item = items[head++ & (Capacity - 1)];
+      return true;
+    }
+
+  protected:
+    TaskLock lock;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    T items[Capacity];
+};
+
+// messages a second through push/pop, 0 if anything came out of order
+template <typename Ring, typename Message>
+static unsigned long runCopying () {
+  static Ring ring;
+  unsigned long start = TaskPlatform::nowMicros();
+
+  std::thread producer([]() {
+    Message message;
+    memset(message.payload, 0x5A, sizeof(message.payload));
+    for (uint32_t sequence = 0; sequence < SPSC_BENCH_ITEMS; sequence++) {
+      message.sequence = sequence;
+      while (!ring.push(message)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  bool ordered = true;
+  Message message;
+  for (uint32_t expected = 0; expected < SPSC_BENCH_ITEMS; ) {
+    if (!ring.pop(message)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && message.sequence == expected;
+    expected++;
+  }
+  producer.join();
+
+  unsigned long elapsed = TaskPlatform::nowMicros() - start;
+  return ordered ? (unsigned long)(SPSC_BENCH_ITEMS * 1000000ull / (elapsed ? elapsed : 1)) : 0;
+}
+
+// same through claim/publish and front/release, no copy on either side
+template <typename Message>
+static unsigned long runInPlace () {
+  static SpscRing<Message, SPSC_BENCH_CAPACITY> ring;
+  unsigned long start = TaskPlatform::nowMicros();
+
+  std::thread producer([]() {
+    for (uint32_t sequence = 0; sequence < SPSC_BENCH_ITEMS; sequence++) {
+      Message* slot;
+      while ((slot = ring.claim()) == nullptr) {
+        std::this_thread::yield();
+      }
+      slot->sequence = sequence;
+      slot->payload[0] = (uint8_t)sequence;
+      ring.publish();
+    }
+  });
+
+  bool ordered = true;
+  for (uint32_t expected = 0; expected < SPSC_BENCH_ITEMS; ) {
+    Message* slot = ring.front();
+    if (slot == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && slot->sequence == expected;
+    ring.release();
+    expected++;
+  }
+  producer.join();
+
+  unsigned long elapsed = TaskPlatform::nowMicros() - start;
+  return ordered ? (unsigned long)(SPSC_BENCH_ITEMS * 1000000ull / (elapsed ? elapsed : 1)) : 0;
+}
+
+template <uint16_t Bytes>
+static bool runSize () {
+  typedef BenchMessage<Bytes> Message;
+  unsigned long copying = runCopying<SpscRing<Message, SPSC_BENCH_CAPACITY>, Message>();
+  unsigned long inPlace = runInPlace<Message>();
+  unsigned long locked = runCopying<LockedRing<Message, SPSC_BENCH_CAPACITY>, Message>();
+
+  printf("%5u B: push/pop %9lu msg/s, claim/front %9lu msg/s, locked push/pop %9lu msg/s\n",
+    Bytes, copying, inPlace, locked);
+  return copying > 0 && inPlace > 0 && locked > 0;
+}
+
+int main () {
+  // a tracer stamp, a display line, a storage request, a whole gui message
+  bool passed = runSize<16>();
+  passed = runSize<32>() && passed;
+  passed = runSize<128>() && passed;
+  passed = runSize<1024>() && passed;
+
+  if (!passed) {
+    printf("a message came out of order\n");
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <thread>
+#include <atomic>
+#include "../../src/tasks/SpscRing.h"
+
+#define SPSC_STRESS_ITEMS 2000000ul // records pushed through each ring
+#define SPSC_STRESS_CAPACITY 16 // small, so both sides hit full and empty a lot
+
+// a record bigger than one word, so a torn read shows up as a checksum mismatch
+struct StressRecord {
+  uint32_t sequence;
+  uint32_t payload[7];
+  uint32_t checksum;
+};
+
+static void fillRecord (StressRecord* record, uint32_t sequence) {
+  record->sequence = sequence;
+  record->checksum = sequence;
+  for (uint8_t i = 0; i < 7; i++) {
+    record->payload[i] = sequence * 2654435761u + i;
+    record->checksum ^= record->payload[i];
+  }
+}
+
+static bool checkRecord (const StressRecord* record, uint32_t expected) {
+  if (record->sequence != expected) {
+    return false;
+  }
+  uint32_t checksum = record->sequence;
+  for (uint8_t i = 0; i < 7; i++) {
+    checksum ^= record->payload[i];
+  }
+  return checksum == record->checksum;
+}
+
+// push/pop, copying the record both ways
+static bool runCopying () {
+  SpscRing<StressRecord, SPSC_STRESS_CAPACITY> ring;
+  bool failed = false;
+  std::atomic<bool> stopped(false); // consumer gave up, so the producer mustn't wait on a full ring
+
+  std::thread producer([&ring, &stopped]() {
+    StressRecord record;
+    for (uint32_t sequence = 0; sequence < SPSC_STRESS_ITEMS; sequence++) {
+      fillRecord(&record, sequence);
+      while (!ring.push(record)) {
+        if (stopped) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  StressRecord record;
+  for (uint32_t expected = 0; expected < SPSC_STRESS_ITEMS; ) {
+    if (!ring.pop(record)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (!checkRecord(&record, expected)) {
+      printf("push/pop: record %u came out as %u or torn\n", expected, record.sequence);
+      failed = true;
+      stopped = true;
+      break;
+    }
+    expected++;
+  }
+
+  producer.join();
+  if (!failed && !ring.isEmpty()) {
+    printf("push/pop: %u records left over\n", ring.getCount());
+    failed = true;
+  }
+  return !failed;
+}
+
+// claim/publish and front/release, working on the slot in place
+static bool runInPlace () {
+  SpscRing<StressRecord, SPSC_STRESS_CAPACITY> ring;
+  bool failed = false;
+  std::atomic<bool> stopped(false);
+
+  std::thread producer([&ring, &stopped]() {
+    for (uint32_t sequence = 0; sequence < SPSC_STRESS_ITEMS; sequence++) {
+      StressRecord* slot;
+      while ((slot = ring.claim()) == nullptr) {
+        if (stopped) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+      fillRecord(slot, sequence);
+      ring.publish();
+    }
+  });
+
+  for (uint32_t expected = 0; expected < SPSC_STRESS_ITEMS; ) {
+    StressRecord* slot = ring.front();
+    if (slot == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    bool valid = checkRecord(slot, expected);
+    uint32_t sequence = slot->sequence;
+    ring.release();
+    if (!valid) {
+      printf("claim/front: record %u came out as %u or torn\n", expected, sequence);
+      failed = true;
+      stopped = true;
+      break;
+    }
+    expected++;
+  }
+
+  producer.join();
+  return !failed;
+}
+
+int main () {
+  unsigned long start = TaskPlatform::nowMicros();
+  bool copying = runCopying();
+  bool inPlace = runInPlace();
+  unsigned long elapsed = TaskPlatform::nowMicros() - start;
+
+  printf("spsc stress: %lu records x2 in %lu ms, push/pop %s, claim/front %s\n",
+    SPSC_STRESS_ITEMS, elapsed / 1000, copying ? "ok" : "FAILED", inPlace ? "ok" : "FAILED");
+  return copying && inPlace ? 0 : 1;
+}
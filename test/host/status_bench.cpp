@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include "../../src/display/LineLayoutCache.h"
+#include "../../src/tasks/TaskPlatform.h"
+#include "FakeDisplay.h"
+
+#define BENCH_CYCLES 20000ul
+#define BENCH_STATUS_LINE 2 // DISPLAY_STATUS_ROW
+#define BENCH_CYCLE_MILLIS 5 // a control cycle with nothing to receive
+#define BENCH_PACKET_MILLIS 40 // receiving and answering one packet
+
+static uint32_t benchSeed = 1;
+static uint32_t benchRandom () {
+  benchSeed = benchSeed * 1103515245u + 12345u;
+  return benchSeed >> 16;
+}
+
+struct CycleCost {
+  unsigned long packets;
+  unsigned long statusWrites;
+  unsigned long hostMicros; // drawing, measured here
+  unsigned long busMicros; // i2c, modeled from the bytes sent
+  unsigned long busBytes;
+};
+
+// the statuses processOneCycle shows, a burst of 0-3 packets a cycle
+static uint8_t cycleStatuses (const char** statuses, uint8_t packets) {
+  uint8_t count = 0;
+  statuses[count++] = "Listening";
+  for (uint8_t i = 0; i < packets; i++) {
+    statuses[count++] = "Receiving";
+  }
+  if (packets == 0) {
+    statuses[count++] = "Mesh";
+  }
+  statuses[count++] = "Ready";
+  return count;
+}
+
+static uint8_t nextPackets () {
+  uint32_t roll = benchRandom() % 10;
+  return roll < 5 ? 0 : (roll < 8 ? 1 : (roll < 9 ? 2 : 3));
+}
+
+// before: every showStatus drew its line and pushed the whole frame
+static CycleCost runRedrawPerStatus () {
+  static uint8_t frame[FRAME_BUFFER_SIZE];
+  FakeBusSink bus;
+  CycleCost cost = {};
+  benchSeed = 1;
+
+  unsigned long start = TaskPlatform::nowMicros();
+  for (unsigned long cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+    const char* statuses[8];
+    uint8_t packets = nextPackets();
+    uint8_t count = cycleStatuses(statuses, packets);
+    cost.packets += packets;
+    for (uint8_t i = 0; i < count; i++) {
+      fakeDrawLine(frame, BENCH_STATUS_LINE, statuses[i], LAYOUT_BAND_LEFT, LAYOUT_BAND_RIGHT);
+      bus.writeFrame();
+      cost.statusWrites++;
+    }
+  }
+  cost.hostMicros = TaskPlatform::nowMicros() - start;
+  cost.busBytes = bus.busBytes;
+  cost.busMicros = bus.getBusMicros();
+  return cost;
+}
+
+// after: showStatus is a state write, the refresh draws whatever is current once a frame is due
+static CycleCost runCoalesced () {
+  static uint8_t frame[FRAME_BUFFER_SIZE];
+  static LineLayoutCache layouts;
+  FakeBusSink bus;
+  FrameCompositor compositor(&bus);
+  CycleCost cost = {};
+  benchSeed = 1;
+
+  char statusLine[LAYOUT_TEXT_MAX] = "";
+  char shownLine[LAYOUT_TEXT_MAX] = "";
+  bool dirty = false;
+  unsigned long now = 0;
+
+  unsigned long start = TaskPlatform::nowMicros();
+  for (unsigned long cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+    const char* statuses[8];
+    uint8_t packets = nextPackets();
+    uint8_t count = cycleStatuses(statuses, packets);
+    cost.packets += packets;
+    for (uint8_t i = 0; i < count; i++) {
+      snprintf(statusLine, sizeof(statusLine), "%s", statuses[i]);
+      dirty = true;
+      cost.statusWrites++;
+    }
+    now += BENCH_CYCLE_MILLIS + packets * BENCH_PACKET_MILLIS;
+
+    // refreshDisplay at the end of the cycle
+    if (dirty && compositor.isFrameDue(now)) {
+      dirty = false;
+      if (strcmp(statusLine, shownLine) != 0) {
+        snprintf(shownLine, sizeof(shownLine), "%s", statusLine);
+        LineLayout* layout = layouts.find(BENCH_STATUS_LINE, statusLine);
+        if (layout != nullptr) {
+          layouts.render(layout, frame);
+        }
+        else {
+          fakeDrawLine(frame, BENCH_STATUS_LINE, statusLine, LAYOUT_BAND_LEFT, LAYOUT_BAND_RIGHT);
+          uint16_t width = fakeStringWidth(statusLine);
+          layouts.store(BENCH_STATUS_LINE, statusLine, (FRAME_WIDTH - width) / 2, FAKE_TEXT_TOP + BENCH_STATUS_LINE * FAKE_LINE_HEIGHT, width, frame);
+        }
+      }
+      compositor.flush(frame, now);
+    }
+  }
+  cost.hostMicros = TaskPlatform::nowMicros() - start;
+  cost.busBytes = bus.busBytes;
+  cost.busMicros = bus.getBusMicros();
+  return cost;
+}
+
+static void printCost (const char* name, CycleCost* cost) {
+  printf("%-17s: %lu packets, %lu status writes, %8lu B i2c in all, per packet %8.1f B i2c, %8.1f us i2c, %6.2f us drawing\n",
+    name, cost->packets, cost->statusWrites, cost->busBytes, (double)cost->busBytes / cost->packets,
+    (double)cost->busMicros / cost->packets, (double)cost->hostMicros / cost->packets);
+}
+
+int main () {
+  CycleCost before = runRedrawPerStatus();
+  CycleCost after = runCoalesced();
+  printCost("redraw per status", &before);
+  printCost("coalesced", &after);
+
+  // the receive path should no longer pay for the display per status
+  bool passed = before.packets == after.packets && after.busBytes * 10 < before.busBytes;
+  if (!passed) {
+    printf("coalescing should cut the i2c traffic per packet at least tenfold\n");
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include "../../src/tasks/StepRuntime.h"
+
+static unsigned long fakeMillis = 0;
+static unsigned long fakeClock () { return fakeMillis; }
+
+static bool passed = true;
+static void expect (bool condition, const char* what) {
+  if (!condition) {
+    printf("FAILED: %s\n", what);
+    passed = false;
+  }
+}
+
+// sleeps 100 ms three times, then finishes
+static uint8_t pulses = 0;
+static unsigned long pulseStep () {
+  pulses++;
+  return pulses < 4 ? 100 : STEP_FINISHED;
+}
+
+// the shape of the factory reset hold: a stage per check, done after a few
+class HoldFlow {
+  public:
+    uint8_t checks = 0;
+    bool completed = false;
+    bool held = true;
+
+    void stepHold (StepTask* task, unsigned long now) {
+      checks++;
+      if (!held) {
+        task->finish();
+      }
+      else if (task->getStage() >= 3) {
+        completed = true;
+        task->finish();
+      }
+      else {
+        task->setStage(task->getStage() + 1);
+        task->sleepFor(now, 250);
+      }
+    }
+};
+
+static void runUntilIdle (StepRuntime* runtime, unsigned long limitMillis) {
+  unsigned long end = fakeMillis + limitMillis;
+  while (runtime->getCount() > 0 && (long)(end - fakeMillis) > 0) {
+    runtime->runDue();
+    unsigned long next = runtime->getMillisUntilNext();
+    fakeMillis += next == STEP_FINISHED ? 1 : (next > 0 ? next : 1);
+  }
+}
+
+static void testFunctionTask () {
+  fakeMillis = 1000;
+  StepRuntime runtime(fakeClock);
+  StepFunctionTask pulse(pulseStep);
+
+  expect(runtime.getMillisUntilNext() == STEP_FINISHED, "nothing running reports STEP_FINISHED");
+  runtime.start(&pulse);
+  expect(runtime.getMillisUntilNext() == 0, "a started task runs on the next pass");
+  expect(runtime.runDue() == 1 && pulses == 1, "first step runs right away");
+  expect(runtime.getMillisUntilNext() == 100, "then sleeps for what it returned");
+
+  fakeMillis += 99;
+  expect(runtime.runDue() == 0, "nothing runs before the wake time");
+  fakeMillis += 1;
+  expect(runtime.runDue() == 1 && pulses == 2, "runs once the wake time comes");
+
+  runUntilIdle(&runtime, 1000);
+  expect(pulses == 4 && pulse.isFinished() && runtime.getCount() == 0, "finishing removes the task");
+  expect(fakeMillis == 1301, "three 100 ms sleeps, stepped exactly on time");
+}
+
+static void testMethodTask () {
+  fakeMillis = 0;
+  StepRuntime runtime(fakeClock);
+  HoldFlow flow;
+  StepMethodTask<HoldFlow> hold(&flow, &HoldFlow::stepHold);
+
+  runtime.start(&hold);
+  runUntilIdle(&runtime, 5000);
+  expect(flow.completed && flow.checks == 4 && fakeMillis == 751, "stages carry over between steps");
+
+  // a restart goes back to stage 0, and letting go ends it early
+  flow = HoldFlow();
+  runtime.start(&hold);
+  expect(hold.getStage() == 0, "start resets the stage");
+  runtime.runDue();
+  flow.held = false;
+  runUntilIdle(&runtime, 5000);
+  expect(!flow.completed && flow.checks == 2, "a released button finishes without resetting");
+}
+
+static void testCapacityAndStop () {
+  fakeMillis = 0;
+  StepRuntime runtime(fakeClock);
+  StepFunctionTask tasks[STEP_RUNTIME_MAX_TASKS + 1] = {
+    pulseStep, pulseStep, pulseStep, pulseStep, pulseStep, pulseStep, pulseStep, pulseStep, pulseStep
+  };
+  for (uint8_t i = 0; i < STEP_RUNTIME_MAX_TASKS; i++) {
+    expect(runtime.start(&tasks[i]), "starts up to the limit");
+  }
+  expect(!runtime.start(&tasks[STEP_RUNTIME_MAX_TASKS]), "one past the limit is refused");
+  expect(tasks[STEP_RUNTIME_MAX_TASKS].isFinished(), "and comes back finished");
+  expect(runtime.start(&tasks[0]) && runtime.getCount() == STEP_RUNTIME_MAX_TASKS, "restarting a running task doesn't add it twice");
+
+  runtime.stop(&tasks[3]);
+  expect(!runtime.isRunning(&tasks[3]) && runtime.getCount() == STEP_RUNTIME_MAX_TASKS - 1, "stop removes the task");
+}
+
+static void testClockWrap () {
+  fakeMillis = 0xFFFFFFFFul - 50;
+  StepRuntime runtime(fakeClock);
+  pulses = 0;
+  StepFunctionTask pulse(pulseStep);
+  runtime.start(&pulse);
+  runtime.runDue();
+  expect(runtime.getMillisUntilNext() == 100, "wake time past the wrap still counts down");
+  fakeMillis += 60;
+  expect(runtime.runDue() == 0, "not due just after the wrap");
+  fakeMillis += 40;
+  expect(runtime.runDue() == 1, "due on time after the wrap");
+}
+
+int main () {
+  testFunctionTask();
+  testMethodTask();
+  testCapacityAndStop();
+  testClockWrap();
+  printf("step runtime: %s\n", passed ? "ok" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <atomic>
+#include <algorithm>
+#include "../../src/tasks/TaskPlatform.h"
+#include "../../src/tasks/SpscRing.h"
+
+#define BENCH_RUN_MILLIS 3000
+#define BENCH_ARRIVAL_MILLIS 7 // a packet this often on average
+#define BENCH_HANDLE_MICROS 1000 // receiving and acking one packet
+#define BENCH_STORAGE_INTERVAL 500 // storage flush and display pass this often
+#define BENCH_ZONES_PER_FLUSH 4
+#define BENCH_ZONE_WRITE_MILLIS 30 // one zone to SD
+#define BENCH_DISPLAY_MILLIS 20 // oled frame
+#define BENCH_MAX_SAMPLES 2048
+
+// what the split looks like in ControlLayer: the radio and housekeeping share the chatter lock,
+// housekeeping takes it for one journaled zone at a time and draws the display without it
+struct SplitBench {
+  TaskLock chatterLock;
+  SpscRing<unsigned long, 64> arrivals; // interrupt -> radio, arrival time in micros
+  std::atomic<bool> running {true};
+  std::atomic<int> tasksDone {0};
+  bool split = false;
+
+  unsigned long latencies[BENCH_MAX_SAMPLES];
+  uint16_t latencyCount = 0;
+};
+
+static void busyMicros (unsigned long micros) {
+  unsigned long start = TaskPlatform::nowMicros();
+  while (TaskPlatform::nowMicros() - start < micros) {
+  }
+}
+
+static void storageAndDisplay (SplitBench* bench) {
+  for (uint8_t zone = 0; zone < BENCH_ZONES_PER_FLUSH; zone++) {
+    TaskLockGuard guard(&bench->chatterLock);
+    TaskPlatform::sleepMillis(BENCH_ZONE_WRITE_MILLIS);
+  }
+  if (bench->split) {
+    // drawing doesn't need chatter once it's on the housekeeping task
+    TaskPlatform::sleepMillis(BENCH_DISPLAY_MILLIS);
+  }
+  else {
+    TaskLockGuard guard(&bench->chatterLock);
+    TaskPlatform::sleepMillis(BENCH_DISPLAY_MILLIS);
+  }
+}
+
+static void interruptTask (void* arg) {
+  SplitBench* bench = (SplitBench*)arg;
+  uint32_t seed = 7;
+  while (bench->running) {
+    seed = seed * 1103515245u + 12345u;
+    TaskPlatform::sleepMillis(1 + (seed >> 16) % (BENCH_ARRIVAL_MILLIS * 2));
+    bench->arrivals.push(TaskPlatform::nowMicros());
+  }
+  bench->tasksDone++;
+}
+
+static void radioTask (void* arg) {
+  SplitBench* bench = (SplitBench*)arg;
+  unsigned long nextStorage = TaskPlatform::nowMillis() + BENCH_STORAGE_INTERVAL;
+  while (bench->running) {
+    {
+      TaskLockGuard guard(&bench->chatterLock);
+      unsigned long arrivedAt;
+      while (bench->arrivals.pop(arrivedAt)) {
+        busyMicros(BENCH_HANDLE_MICROS);
+        if (bench->latencyCount < BENCH_MAX_SAMPLES) {
+          bench->latencies[bench->latencyCount++] = TaskPlatform::nowMicros() - arrivedAt;
+        }
+      }
+    }
+
+    // without the split the loop does the storage and display work itself
+    if (!bench->split && (long)(TaskPlatform::nowMillis() - nextStorage) >= 0) {
+      storageAndDisplay(bench);
+      nextStorage += BENCH_STORAGE_INTERVAL;
+    }
+    TaskPlatform::sleepMillis(1);
+  }
+  bench->tasksDone++;
+}
+
+static void housekeepingTask (void* arg) {
+  SplitBench* bench = (SplitBench*)arg;
+  while (bench->running) {
+    TaskPlatform::sleepMillis(BENCH_STORAGE_INTERVAL);
+    storageAndDisplay(bench);
+  }
+  bench->tasksDone++;
+}
+
+// returns the 99th percentile receive latency in micros
+static unsigned long runBench (SplitBench* bench) {
+  int tasks = 2;
+  TaskPlatform::startTask("interrupt", interruptTask, bench, 0, 0, 0);
+  TaskPlatform::startTask("radio", radioTask, bench, 0, 0, TASK_RADIO_CORE);
+  if (bench->split) {
+    TaskPlatform::startTask("housekeeping", housekeepingTask, bench, 0, 0, TASK_HOUSEKEEPING_CORE);
+    tasks++;
+  }
+  TaskPlatform::sleepMillis(BENCH_RUN_MILLIS);
+  bench->running = false;
+  while (bench->tasksDone < tasks) {
+    TaskPlatform::sleepMillis(10);
+  }
+
+  std::sort(bench->latencies, bench->latencies + bench->latencyCount);
+  unsigned long total = 0;
+  for (uint16_t i = 0; i < bench->latencyCount; i++) {
+    total += bench->latencies[i];
+  }
+  unsigned long p99 = bench->latencies[bench->latencyCount * 99 / 100];
+  printf("%-6s: %4d packets, receive latency avg %6lu us, p99 %6lu us, worst %6lu us\n", bench->split ? "split" : "inline",
+    bench->latencyCount, total / bench->latencyCount, p99, bench->latencies[bench->latencyCount - 1]);
+  return p99;
+}
+
+int main () {
+  static SplitBench inlineBench;
+  static SplitBench splitBench;
+  splitBench.split = true;
+
+  unsigned long inlineP99 = runBench(&inlineBench);
+  unsigned long splitP99 = runBench(&splitBench);
+
+  // a radio wait is at most one zone write with the split, the whole flush and frame without it
+  bool passed = splitP99 < inlineP99;
+  if (!passed) {
+    printf("the split should take storage and display out of the receive latency\n");
+  }
+  return passed ? 0 : 1;
+}